@@ -0,0 +1,282 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+//! Benchmarks of the functions that are called from the OpenFOAM interface, on a synthetic set of
+//! cells around a single wing. The number of cells in each direction can be set with the 
+//! environment variable `STORMBIRD_BENCH_CELLS_PER_DIRECTION`. Run with `cargo bench`.
+
+use std::hint::black_box;
+
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+
+use cpp_actuator_line::CppActuatorLine;
+
+use stormbird::actuator_line::builder::ActuatorLineBuilder;
+use stormbird::line_force_model::builder::LineForceModelBuilder;
+use stormbird::line_force_model::builder::single_wing::WingBuilder;
+use stormbird::line_force_model::input_power::InputPowerModel;
+use stormbird::section_models::SectionModel;
+use stormbird::section_models::foil::Foil;
+
+use stormath::spatial_vector::SpatialVector;
+
+/// A rectangular wing with a span of four along the z-axis, and a chord of one along the x-axis
+fn wing_model() -> CppActuatorLine {
+    let mut line_force_model = LineForceModelBuilder::new(20);
+
+    line_force_model.add_wing(WingBuilder{
+        section_points: vec![
+            SpatialVector::from([0.0, 0.0, 0.0]),
+            SpatialVector::from([0.0, 0.0, 4.0]),
+        ],
+        chord_vectors: vec![
+            SpatialVector::from([1.0, 0.0, 0.0]),
+            SpatialVector::from([1.0, 0.0, 0.0]),
+        ],
+        line_segment_is_virtual: None,
+        section_model: SectionModel::Foil(Foil::default()),
+        non_zero_circulation_at_ends: [false, false],
+        nr_sections: None,
+        input_power_model: InputPowerModel::NoPower,
+    });
+
+    let mut model = CppActuatorLine::new(ActuatorLineBuilder::new(line_force_model).build());
+
+    for line_index in 0..model.nr_span_lines() {
+        model.set_velocity_at_index(line_index, [8.0, 1.0, 0.0]);
+    }
+
+    model.do_step(0.0, 0.01);
+
+    model
+}
+
+/// Cell data in the same layout as the views of the OpenFOAM fields
+struct SyntheticCells {
+    centers: Vec<f64>,
+    volumes: Vec<f64>,
+    velocity: Vec<f64>,
+    ids: Vec<i32>,
+    line_indices: Vec<i32>,
+}
+
+impl SyntheticCells {
+    /// A uniform grid of cells in a box around the wing
+    fn new(model: &CppActuatorLine) -> Self {
+        let nr_cells_per_direction: usize = std::env::var("STORMBIRD_BENCH_CELLS_PER_DIRECTION")
+            .ok()
+            .and_then(|value| value.parse().ok())
+            .unwrap_or(40);
+
+        let min = [-1.0, -1.0, -0.5];
+        let max = [2.0, 1.0, 4.5];
+
+        let spacing: Vec<f64> = (0..3)
+            .map(|d| (max[d] - min[d]) / nr_cells_per_direction as f64)
+            .collect();
+
+        let nr_cells = nr_cells_per_direction.pow(3);
+
+        let mut centers = Vec::with_capacity(3 * nr_cells);
+
+        for k in 0..nr_cells_per_direction {
+            for j in 0..nr_cells_per_direction {
+                for i in 0..nr_cells_per_direction {
+                    centers.push(min[0] + (i as f64 + 0.5) * spacing[0]);
+                    centers.push(min[1] + (j as f64 + 0.5) * spacing[1]);
+                    centers.push(min[2] + (k as f64 + 0.5) * spacing[2]);
+                }
+            }
+        }
+
+        let ids: Vec<i32> = (0..nr_cells as i32).collect();
+
+        let line_indices = ids.iter().map(|cell_id| {
+            let index = 3 * *cell_id as usize;
+
+            let point = [centers[index], centers[index + 1], centers[index + 2]];
+
+            model.dominating_line_element_index_at_point(&point) as i32
+        }).collect();
+
+        Self {
+            centers,
+            volumes: vec![spacing[0] * spacing[1] * spacing[2]; nr_cells],
+            velocity: [8.0, 1.0, 0.0].repeat(nr_cells),
+            ids,
+            line_indices,
+        }
+    }
+
+    fn center(&self, cell_id: usize) -> [f64; 3] {
+        [self.centers[3 * cell_id], self.centers[3 * cell_id + 1], self.centers[3 * cell_id + 2]]
+    }
+
+    fn velocity(&self, cell_id: usize) -> [f64; 3] {
+        [self.velocity[3 * cell_id], self.velocity[3 * cell_id + 1], self.velocity[3 * cell_id + 2]]
+    }
+}
+
+/// The per-cell functions, which are called once for each cell
+fn per_cell_functions(c: &mut Criterion) {
+    let model = wing_model();
+    let cells = SyntheticCells::new(&model);
+
+    let mut group = c.benchmark_group("per_cell");
+    group.throughput(Throughput::Elements(cells.ids.len() as u64));
+
+    group.bench_function("summed_projection_weights_at_point", |b| b.iter(|| {
+        let mut sum = 0.0;
+
+        for cell_id in 0..cells.ids.len() {
+            sum += model.summed_projection_weights_at_point(&cells.center(cell_id));
+        }
+
+        black_box(sum)
+    }));
+
+    group.bench_function("get_weighted_velocity_sampling_integral_terms_for_cell", |b| b.iter(|| {
+        let mut sum = [0.0; 4];
+
+        for cell_id in 0..cells.ids.len() {
+            let terms = model.get_weighted_velocity_sampling_integral_terms_for_cell(
+                cells.line_indices[cell_id] as usize,
+                &cells.velocity(cell_id),
+                &cells.center(cell_id),
+                cells.volumes[cell_id]
+            );
+
+            for i in 0..4 {
+                sum[i] += terms[i];
+            }
+        }
+
+        black_box(sum)
+    }));
+
+    group.bench_function("force_to_project", |b| b.iter(|| {
+        let mut sum = [0.0; 3];
+
+        for cell_id in 0..cells.ids.len() {
+            let force = model.force_to_project(
+                cells.line_indices[cell_id] as usize, 
+                &cells.velocity(cell_id)
+            );
+
+            for i in 0..3 {
+                sum[i] += force[i];
+            }
+        }
+
+        black_box(sum)
+    }));
+
+    group.finish();
+}
+
+/// The batch functions, which take views of the whole fields, as used by the OpenFOAM interface
+fn batch_functions(c: &mut Criterion) {
+    let model = wing_model();
+    let cells = SyntheticCells::new(&model);
+
+    let nr_cells = cells.ids.len();
+
+    let mut group = c.benchmark_group("batch");
+    group.throughput(Throughput::Elements(nr_cells as u64));
+
+    let mut summed_weights = vec![0.0; nr_cells];
+    let mut max_weights = vec![0.0; nr_cells];
+    let mut dominating_line_indices = vec![0; nr_cells];
+
+    group.bench_function("wing_projection_data_at_cells", |b| b.iter(|| {
+        model.wing_projection_data_at_cells(
+            0,
+            &cells.centers,
+            &cells.ids,
+            &mut summed_weights,
+            &mut max_weights,
+            &mut dominating_line_indices
+        );
+
+        black_box(&summed_weights);
+    }));
+
+    let weight_limit = model.projection_weight_limit() / model.nr_span_lines() as f64;
+
+    group.bench_function("wing_line_element_weights_at_cells", |b| b.iter(|| {
+        black_box(
+            model.wing_line_element_weights_at_cells(0, &cells.centers, &cells.ids, weight_limit)
+        )
+    }));
+
+    let mut sampling_weights = vec![0.0; nr_cells];
+
+    group.bench_function("velocity_sampling_weights_at_cells", |b| b.iter(|| {
+        model.velocity_sampling_weights_at_cells(
+            &cells.centers,
+            &cells.volumes,
+            &cells.ids,
+            &cells.line_indices,
+            &mut sampling_weights
+        );
+
+        black_box(&sampling_weights);
+    }));
+
+    let mut sums = vec![0.0; 4 * model.nr_span_lines()];
+
+    group.bench_function("add_weighted_velocity_sampling_sums", |b| b.iter(|| {
+        sums.fill(0.0);
+
+        model.add_weighted_velocity_sampling_sums(
+            &cells.velocity,
+            &cells.ids,
+            &cells.line_indices,
+            &sampling_weights,
+            &mut sums
+        );
+
+        black_box(&sums);
+    }));
+
+    // Projection matrix with one row for each cell, in the same format as in the OpenFOAM 
+    // interface
+    let line_element_weights = model.wing_line_element_weights_at_cells(
+        0, &cells.centers, &cells.ids, weight_limit
+    );
+
+    let mut row_offsets = vec![0i32; nr_cells + 1];
+    let mut line_indices = Vec::with_capacity(line_element_weights.len());
+    let mut values = Vec::with_capacity(line_element_weights.len());
+
+    for weight in line_element_weights.iter() {
+        row_offsets[weight.point_index + 1] += 1;
+        line_indices.push(weight.line_index as i32);
+        values.push(weight.weight * cells.volumes[weight.point_index]);
+    }
+
+    for row in 0..nr_cells {
+        row_offsets[row + 1] += row_offsets[row];
+    }
+
+    let mut body_forces = vec![0.0; 3 * nr_cells];
+
+    group.bench_function("realigned_body_forces_at_cells", |b| b.iter(|| {
+        model.realigned_body_forces_at_cells(
+            &cells.velocity,
+            &cells.ids,
+            &row_offsets,
+            &line_indices,
+            &values,
+            &mut body_forces
+        );
+
+        black_box(&body_forces);
+    }));
+
+    group.finish();
+}
+
+criterion_group!(benches, per_cell_functions, batch_functions);
+criterion_main!(benches);
@@ -3,26 +3,42 @@
 // License: GPL v3.0 (see seperate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
 
 
+mod result_writer;
+
 use stormbird::actuator_line::ActuatorLine;
 
 use stormath::spatial_vector::SpatialVector;
 
+use result_writer::ResultWriter;
+
 #[cxx::bridge(namespace="stormbird_interface")]
 mod ffi {
+    /// The projection weight from a single line element at a single point
+    struct LineElementWeight {
+        point_index: usize,
+        line_index: usize,
+        weight: f64,
+    }
+
     extern "Rust" {
         type CppActuatorLine;
 
         // ---- Constructors ----
         fn new_actuator_line_from_file(file_path: &str) -> *mut CppActuatorLine;
+        fn new_actuator_line_from_string(builder_string: &str) -> *mut CppActuatorLine;
+        unsafe fn delete_actuator_line(model: *mut CppActuatorLine);
 
         // ---- Settings accessors ----
         fn use_point_sampling(&self) -> bool;
         fn sampling_weight_limit(&self) -> f64;
         fn projection_weight_limit(&self) -> f64;
+        fn realign_to_local_velocity_at_each_cell(&self) -> bool;
+        fn blend_line_elements(&self) -> bool;
 
         // ---- Setters and getters ----
         fn nr_span_lines(&self) -> usize;
         fn nr_wings(&self) -> usize;
+        fn wing_line_indices(&self, wing_index: usize) -> [usize; 2];
 
         fn get_local_wing_angle(&self, index: usize) -> f64;
         fn set_local_wing_angle(&mut self, index: usize, angle: f64);
@@ -37,12 +53,48 @@ mod ffi {
             cell_volume: f64,
         ) -> [f64; 4];
 
+        fn velocity_sampling_weights_at_cells(
+            &self,
+            cell_centers: &[f64],
+            cell_volumes: &[f64],
+            cell_ids: &[i32],
+            line_indices: &[i32],
+            weights: &mut [f64]
+        );
+        fn add_weighted_velocity_sampling_sums(
+            &self,
+            velocity_field: &[f64],
+            cell_ids: &[i32],
+            line_indices: &[i32],
+            weights: &[f64],
+            sums: &mut [f64]
+        );
+        fn velocity_sampling_weights_at_cells_single(
+            &self,
+            cell_centers: &[f64],
+            cell_volumes: &[f64],
+            cell_ids: &[i32],
+            line_indices: &[i32],
+            weights: &mut [f32]
+        );
+        fn add_weighted_velocity_sampling_sums_single(
+            &self,
+            velocity_field: &[f64],
+            cell_ids: &[i32],
+            line_indices: &[i32],
+            weights: &[f32],
+            sums: &mut [f64]
+        );
+        fn set_velocity_from_sampling_sums(&mut self, sums: &[f64]);
+
         fn set_velocity_at_index(&mut self, index: usize, velocity: [f64; 3]);
 
         fn dominating_line_element_index_at_point(&self, point: &[f64; 3]) -> usize;
 
         // ---- Force methods ----
         fn do_step(&mut self, time: f64, time_step: f64);
+        fn repeat_step(&mut self, time: f64, time_step: f64);
+        fn is_solve_step(&self, time: f64, time_step: f64) -> bool;
         fn update_controller(&mut self, time: f64, time_step: f64) -> bool;
 
         fn force_to_project(
@@ -51,65 +103,288 @@ mod ffi {
             velocity: &[f64; 3]
         ) -> [f64; 3];
         fn summed_projection_weights_at_point(&self, point: &[f64; 3]) -> f64;
+        fn wing_projection_data_at_cells(
+            &self,
+            wing_index: usize,
+            cell_centers: &[f64],
+            cell_ids: &[i32],
+            summed_weights: &mut [f64],
+            max_weights: &mut [f64],
+            dominating_line_indices: &mut [usize]
+        );
+        fn line_element_swept_bounding_box(&self, line_index: usize, weight_limit: f64) -> [f64; 6];
+        fn wing_line_element_weights_at_cells(
+            &self,
+            wing_index: usize,
+            cell_centers: &[f64],
+            cell_ids: &[i32],
+            weight_limit: f64
+        ) -> Vec<LineElementWeight>;
+        fn wing_line_element_weights_at_cells_single(
+            &self,
+            wing_index: usize,
+            cell_centers: &[f64],
+            cell_ids: &[i32],
+            weight_limit: f64
+        ) -> Vec<LineElementWeight>;
+        fn realigned_body_forces_at_cells(
+            &self,
+            velocity_field: &[f64],
+            cell_ids: &[i32],
+            row_offsets: &[i32],
+            line_indices: &[i32],
+            values: &[f64],
+            body_forces: &mut [f64]
+        );
+        fn realigned_body_forces_at_cells_single(
+            &self,
+            velocity_field: &[f64],
+            cell_ids: &[i32],
+            row_offsets: &[i32],
+            line_indices: &[i32],
+            values: &[f32],
+            body_forces: &mut [f64]
+        );
+        fn get_sectional_forces_to_project(&self, forces: &mut [f64]);
+        fn get_sectional_lift_and_drag_forces_to_project(&self, forces: &mut [f64]);
+        fn set_sectional_lift_and_drag_forces_to_project(&mut self, forces: &[f64]);
 
         // ---- Export data ----
-        fn write_results(&self, folder_path: &str);
+        fn write_results(&mut self, folder_path: &str);
+        fn write_results_asynchronously(&mut self, folder_path: &str);
+
+        // ---- Restart ----
+        fn write_restart_state(&self, file_path: &str);
+        fn read_restart_state(&mut self, file_path: &str) -> bool;
+        fn geometry_hash(&self) -> u64;
+
+        // ---- Body frame motion ----
+        fn set_body_frame_reference(&mut self);
+        fn move_with_body_frame(&mut self, rotation_matrix: &[f64; 9], translation: &[f64; 3], time_step: f64);
     }
 }
 
 pub struct CppActuatorLine {
-    model: ActuatorLine
+    model: ActuatorLine,
+    /// Background writer, created at the first call to asynchronous result writing
+    result_writer: Option<ResultWriter>,
+}
+
+// The OpenFOAM interface calls the `&self` methods from several threads at the same time when 
+// running with more than one thread per processor. This is only safe as long as the model is Sync.
+const _: () = {
+    const fn assert_sync<T: Sync>() {}
+    assert_sync::<CppActuatorLine>();
+};
+
+// The functions that end with `_at_cells` take views of OpenFOAM fields directly, so that nothing
+// is copied on the C++ side. Vector fields are three consecutive f64 values per cell, scalar 
+// fields are one f64 value per cell, and cell indices and other labels are i32 values. The C++ 
+// side checks at compile time that the OpenFOAM types have this layout.
+
+/// Returns the vector with the input index from a flat view of a vector field
+fn vector_at(field: &[f64], index: usize) -> SpatialVector {
+    SpatialVector::from([field[3 * index], field[3 * index + 1], field[3 * index + 2]])
+}
+
+/// Number of cells that are gathered and evaluated together in the batch projection kernels
+const POINT_BLOCK_SIZE: usize = 256;
+
+#[derive(Default)]
+/// Cell centers for a block of cells, with separate arrays for each coordinate as expected by the
+/// batch projection kernels in Stormbird
+struct PointBlock {
+    x: Vec<f64>,
+    y: Vec<f64>,
+    z: Vec<f64>,
+}
+
+impl PointBlock {
+    fn gather(&mut self, cell_centers: &[f64], cell_ids: impl Iterator<Item = i32>) {
+        self.x.clear();
+        self.y.clear();
+        self.z.clear();
+
+        for cell_id in cell_ids {
+            let index = 3 * cell_id as usize;
+
+            self.x.push(cell_centers[index]);
+            self.y.push(cell_centers[index + 1]);
+            self.z.push(cell_centers[index + 2]);
+        }
+    }
+
+    /// Returns the minimum and maximum point of the axis aligned box around the points
+    fn bounding_box(&self) -> [SpatialVector; 2] {
+        let min_max = |values: &[f64]| {
+            values.iter().fold(
+                (f64::INFINITY, f64::NEG_INFINITY), 
+                |(min, max), &value| (min.min(value), max.max(value))
+            )
+        };
+
+        let (x_min, x_max) = min_max(&self.x);
+        let (y_min, y_max) = min_max(&self.y);
+        let (z_min, z_max) = min_max(&self.z);
+
+        [
+            SpatialVector::from([x_min, y_min, z_min]),
+            SpatialVector::from([x_max, y_max, z_max])
+        ]
+    }
+}
+
+/// Checks if two axis aligned boxes, given as the minimum and maximum point, overlap
+fn boxes_overlap(a: &[SpatialVector; 2], b: &[SpatialVector; 2]) -> bool {
+    (0..3).all(|d| a[0][d] <= b[1][d] && b[0][d] <= a[1][d])
+}
+
+/// The precision of stored projection and sampling weights. The functions that end with `_single`
+/// evaluate and store the weights in single precision, which halves the memory traffic for the 
+/// stored data. All sums and the model itself are still computed in double precision.
+trait WeightPrecision: Copy + Default + Into<f64> + std::ops::Mul<Output = Self> {
+    fn from_f64(value: f64) -> Self;
+
+    fn line_segment_projection_weights(
+        model: &ActuatorLine, line_index: usize, points: &PointBlock, weights: &mut [Self]
+    );
+
+    fn velocity_sampling_weights(
+        model: &ActuatorLine, line_index: usize, points: &PointBlock, weights: &mut [Self]
+    );
+}
+
+impl WeightPrecision for f64 {
+    fn from_f64(value: f64) -> Self {
+        value
+    }
+
+    fn line_segment_projection_weights(
+        model: &ActuatorLine, line_index: usize, points: &PointBlock, weights: &mut [Self]
+    ) {
+        model.line_segment_projection_weights_at_points(
+            line_index, &points.x, &points.y, &points.z, weights
+        );
+    }
+
+    fn velocity_sampling_weights(
+        model: &ActuatorLine, line_index: usize, points: &PointBlock, weights: &mut [Self]
+    ) {
+        model.velocity_sampling_weights_at_points(
+            line_index, &points.x, &points.y, &points.z, weights
+        );
+    }
+}
+
+impl WeightPrecision for f32 {
+    fn from_f64(value: f64) -> Self {
+        value as f32
+    }
+
+    fn line_segment_projection_weights(
+        model: &ActuatorLine, line_index: usize, points: &PointBlock, weights: &mut [Self]
+    ) {
+        model.line_segment_projection_weights_at_points_single(
+            line_index, &points.x, &points.y, &points.z, weights
+        );
+    }
+
+    fn velocity_sampling_weights(
+        model: &ActuatorLine, line_index: usize, points: &PointBlock, weights: &mut [Self]
+    ) {
+        model.velocity_sampling_weights_at_points_single(
+            line_index, &points.x, &points.y, &points.z, weights
+        );
+    }
 }
 
 fn new_actuator_line_from_file(file_path: &str) -> *mut CppActuatorLine {
-    let mut model = ActuatorLine::new_from_file(file_path);
+    new_cpp_actuator_line(ActuatorLine::new_from_file(file_path))
+}
 
-    // TODO: this is currently a hack. The density needs to be set to one for incompressible,
-    // single-phase, flow, but should ideally take in the values from the CFD simulations in cases
-    // where the density might vary. This needs an update to handle such cases.
-    model.line_force_model.density = 1.0;
+/// Constructs the model from the content of an input file. This allows the file to be read on a
+/// single processor in parallel simulations, and shared with the others.
+fn new_actuator_line_from_string(builder_string: &str) -> *mut CppActuatorLine {
+    new_cpp_actuator_line(ActuatorLine::new_from_string(builder_string))
+}
 
-    Box::into_raw(
-        Box::new(
-            CppActuatorLine{model}
-        )
-    )
+fn new_cpp_actuator_line(model: ActuatorLine) -> *mut CppActuatorLine {
+    Box::into_raw(Box::new(CppActuatorLine::new(model)))
+}
+
+/// Deletes a model created by [new_actuator_line_from_file]. This also waits for all results 
+/// queued by the asynchronous result writer to be written.
+unsafe fn delete_actuator_line(model: *mut CppActuatorLine) {
+    if !model.is_null() {
+        drop(Box::from_raw(model));
+    }
 }
 
 impl CppActuatorLine {
-    fn use_point_sampling(&self) -> bool {
+    /// Wraps the input model. The methods are also public, so that the interface can be used
+    /// directly from Rust, for instance in benchmarks.
+    pub fn new(mut model: ActuatorLine) -> Self {
+        // TODO: this is currently a hack. The density needs to be set to one for incompressible,
+        // single-phase, flow, but should ideally take in the values from the CFD simulations in 
+        // cases where the density might vary. This needs an update to handle such cases.
+        model.line_force_model.density = 1.0;
+
+        Self {
+            model,
+            result_writer: None
+        }
+    }
+
+    pub fn use_point_sampling(&self) -> bool {
         self.model.sampling_settings.use_point_sampling
     }
 
-    fn sampling_weight_limit(&self) -> f64 {
+    pub fn sampling_weight_limit(&self) -> f64 {
         self.model.sampling_settings.weight_limit
     }
 
-    fn projection_weight_limit(&self) -> f64 {
+    pub fn projection_weight_limit(&self) -> f64 {
         self.model.projection_settings.weight_limit
     }
 
-    fn nr_span_lines(&self) -> usize {
+    pub fn realign_to_local_velocity_at_each_cell(&self) -> bool {
+        self.model.projection_settings.realign_to_local_velocity_at_each_cell
+    }
+
+    pub fn blend_line_elements(&self) -> bool {
+        self.model.projection_settings.blend_line_elements
+    }
+
+    pub fn nr_span_lines(&self) -> usize {
         self.model.line_force_model.nr_span_lines()
     }
 
-    fn nr_wings(&self) -> usize {
+    pub fn nr_wings(&self) -> usize {
         self.model.line_force_model.nr_wings()
     }
 
-    fn get_ctrl_point_at_index(&self, index: usize) -> [f64; 3] {
+    /// Returns the first and one past the last global line index of the wing at the input index
+    pub fn wing_line_indices(&self, wing_index: usize) -> [usize; 2] {
+        let line_indices = &self.model.line_force_model.wing_indices[wing_index];
+
+        [line_indices.start, line_indices.end]
+    }
+
+    pub fn get_ctrl_point_at_index(&self, index: usize) -> [f64; 3] {
         self.model.line_force_model.span_lines_global[index].ctrl_point().into()
     }
 
-    fn get_local_wing_angle(&self, index: usize) -> f64 {
+    pub fn get_local_wing_angle(&self, index: usize) -> f64 {
         self.model.line_force_model.local_wing_angles[index]
     }
 
-    fn set_local_wing_angle(&mut self, index: usize, angle: f64) {
+    pub fn set_local_wing_angle(&mut self, index: usize, angle: f64) {
         self.model.line_force_model.local_wing_angles[index] = angle;
+
+        self.model.line_force_model.update_global_data_representations();
     }
 
-    fn get_weighted_velocity_sampling_integral_terms_for_cell(
+    pub fn get_weighted_velocity_sampling_integral_terms_for_cell(
         &self,
         line_index: usize,
         velocity: &[f64; 3],
@@ -123,11 +398,160 @@ impl CppActuatorLine {
         [numerator[0], numerator[1], numerator[2], denominator]
     }
 
-    fn set_velocity_at_index(&mut self, index: usize, velocity: [f64; 3]) {
+    /// Computes the geometric weights used in the integral velocity sampling for the input cells,
+    /// multiplied with the cell volumes. Each cell is associated with the line element at the same
+    /// index in `line_indices`.
+    pub fn velocity_sampling_weights_at_cells(
+        &self,
+        cell_centers: &[f64],
+        cell_volumes: &[f64],
+        cell_ids: &[i32],
+        line_indices: &[i32],
+        weights: &mut [f64]
+    ) {
+        self.velocity_sampling_weights_at_cells_in_precision(
+            cell_centers, cell_volumes, cell_ids, line_indices, weights
+        );
+    }
+
+    /// Same as [CppActuatorLine::velocity_sampling_weights_at_cells], but with the weights stored
+    /// in single precision
+    pub fn velocity_sampling_weights_at_cells_single(
+        &self,
+        cell_centers: &[f64],
+        cell_volumes: &[f64],
+        cell_ids: &[i32],
+        line_indices: &[i32],
+        weights: &mut [f32]
+    ) {
+        self.velocity_sampling_weights_at_cells_in_precision(
+            cell_centers, cell_volumes, cell_ids, line_indices, weights
+        );
+    }
+
+    fn velocity_sampling_weights_at_cells_in_precision<W: WeightPrecision>(
+        &self,
+        cell_centers: &[f64],
+        cell_volumes: &[f64],
+        cell_ids: &[i32],
+        line_indices: &[i32],
+        weights: &mut [W]
+    ) {
+        let nr_cells = weights.len();
+
+        assert_eq!(cell_ids.len(), nr_cells);
+        assert_eq!(line_indices.len(), nr_cells);
+
+        // The batch kernel evaluates one line element at the time, so the cells are grouped by
+        // their line element first
+        let mut order: Vec<usize> = (0..nr_cells).collect();
+        order.sort_by_key(|i| line_indices[*i]);
+
+        let mut points = PointBlock::default();
+        let mut block_weights = vec![W::default(); POINT_BLOCK_SIZE];
+
+        for line_cells in order.chunk_by(|a, b| line_indices[*a] == line_indices[*b]) {
+            let line_index = line_indices[line_cells[0]] as usize;
+
+            for block in line_cells.chunks(POINT_BLOCK_SIZE) {
+                points.gather(cell_centers, block.iter().map(|i| cell_ids[*i]));
+
+                let block_weights = &mut block_weights[..block.len()];
+
+                W::velocity_sampling_weights(&self.model, line_index, &points, block_weights);
+
+                for (k, i) in block.iter().enumerate() {
+                    weights[*i] = block_weights[k] * 
+                        W::from_f64(cell_volumes[cell_ids[*i] as usize]);
+                }
+            }
+        }
+    }
+
+    /// Adds the weighted velocity in the input cells to the sampling sums. The sums contain the
+    /// three components of the numerator for each line element, followed by the denominator for
+    /// each line element, so that sums from several threads and processors can be combined by 
+    /// adding the buffers.
+    pub fn add_weighted_velocity_sampling_sums(
+        &self,
+        velocity_field: &[f64],
+        cell_ids: &[i32],
+        line_indices: &[i32],
+        weights: &[f64],
+        sums: &mut [f64]
+    ) {
+        self.add_weighted_velocity_sampling_sums_in_precision(
+            velocity_field, cell_ids, line_indices, weights, sums
+        );
+    }
+
+    /// Same as [CppActuatorLine::add_weighted_velocity_sampling_sums], but with weights stored in
+    /// single precision. The sums are still computed in double precision.
+    pub fn add_weighted_velocity_sampling_sums_single(
+        &self,
+        velocity_field: &[f64],
+        cell_ids: &[i32],
+        line_indices: &[i32],
+        weights: &[f32],
+        sums: &mut [f64]
+    ) {
+        self.add_weighted_velocity_sampling_sums_in_precision(
+            velocity_field, cell_ids, line_indices, weights, sums
+        );
+    }
+
+    fn add_weighted_velocity_sampling_sums_in_precision<W: WeightPrecision>(
+        &self,
+        velocity_field: &[f64],
+        cell_ids: &[i32],
+        line_indices: &[i32],
+        weights: &[W],
+        sums: &mut [f64]
+    ) {
+        let nr_span_lines = self.nr_span_lines();
+        let nr_cells = cell_ids.len();
+
+        assert_eq!(sums.len(), 4 * nr_span_lines);
+        assert_eq!(line_indices.len(), nr_cells);
+        assert_eq!(weights.len(), nr_cells);
+
+        let (numerator, denominator) = sums.split_at_mut(3 * nr_span_lines);
+
+        for i in 0..nr_cells {
+            let cell_id = cell_ids[i] as usize;
+            let line_index = line_indices[i] as usize;
+
+            let weight: f64 = weights[i].into();
+
+            numerator[3 * line_index]     += weight * velocity_field[3 * cell_id];
+            numerator[3 * line_index + 1] += weight * velocity_field[3 * cell_id + 1];
+            numerator[3 * line_index + 2] += weight * velocity_field[3 * cell_id + 2];
+            denominator[line_index] += weight;
+        }
+    }
+
+    /// Sets the velocity at the control points from the sampling sums. Line elements without any 
+    /// sampling weight keep their previous velocity.
+    pub fn set_velocity_from_sampling_sums(&mut self, sums: &[f64]) {
+        let nr_span_lines = self.nr_span_lines();
+
+        assert_eq!(sums.len(), 4 * nr_span_lines);
+
+        let (numerator, denominator) = sums.split_at(3 * nr_span_lines);
+
+        for line_index in 0..nr_span_lines {
+            if denominator[line_index] != 0.0 {
+                self.model.ctrl_points_velocity[line_index] = 
+                    vector_at(numerator, line_index) / denominator[line_index];
+            }
+        }
+    }
+
+    pub fn set_velocity_at_index(&mut self, index: usize, velocity: [f64; 3]) {
         self.model.ctrl_points_velocity[index] = SpatialVector::from(velocity);
     }
 
-    fn dominating_line_element_index_at_point(&self, point: &[f64; 3]) -> usize {
+    pub fn dominating_line_element_index_at_point(&self, point: &[f64; 3]) -> usize {
         self.model.dominating_line_element_index_at_point(SpatialVector::from(*point))
     }
 
@@ -135,6 +559,14 @@ impl CppActuatorLine {
         self.model.do_step(time, time_step)
     }
 
+    pub fn repeat_step(&mut self, time: f64, time_step: f64) {
+        self.model.repeat_step(time, time_step)
+    }
+
+    pub fn is_solve_step(&self, time: f64, time_step: f64) -> bool {
+        self.model.is_solve_step(time, time_step)
+    }
+
     pub fn update_controller(&mut self, time: f64, time_step: f64) -> bool {
         self.model.update_controller(time, time_step)
     }
@@ -156,7 +588,377 @@ impl CppActuatorLine {
         self.model.summed_projection_weights_at_point(SpatialVector::from(*point))
     }
 
-    pub fn write_results(&self, folder_path: &str) {
+    /// Computes the summed projection weights and the dominating line element index for the
+    /// centers of the input cells, only using the line elements on the wing with the input index.
+    /// The maximum weight from a single line element is also returned, so that data from several
+    /// wings can be combined afterwards.
+    pub fn wing_projection_data_at_cells(
+        &self,
+        wing_index: usize,
+        cell_centers: &[f64],
+        cell_ids: &[i32],
+        summed_weights: &mut [f64],
+        max_weights: &mut [f64],
+        dominating_line_indices: &mut [usize]
+    ) {
+        let nr_cells = summed_weights.len();
+
+        assert_eq!(cell_ids.len(), nr_cells);
+        assert_eq!(max_weights.len(), nr_cells);
+        assert_eq!(dominating_line_indices.len(), nr_cells);
+
+        let line_indices = self.model.line_force_model.wing_indices[wing_index].clone();
+
+        let mut points = PointBlock::default();
+
+        for start in (0..nr_cells).step_by(POINT_BLOCK_SIZE) {
+            let end = (start + POINT_BLOCK_SIZE).min(nr_cells);
+
+            points.gather(cell_centers, cell_ids[start..end].iter().copied());
+
+            self.model.projection_data_at_points_for_line_elements(
+                &points.x,
+                &points.y,
+                &points.z,
+                line_indices.clone(),
+                &mut summed_weights[start..end],
+                &mut max_weights[start..end],
+                &mut dominating_line_indices[start..end]
+            );
+        }
+    }
+
+    /// Returns the bounding box of the region where a line element can contribute to summed
+    /// projection weights above the weight limit, for any local wing angle. The box is given as
+    /// the minimum point followed by the maximum point. If no such region exists, the box is empty,
+    /// with the minimum point larger than the maximum point.
+    pub fn line_element_swept_bounding_box(&self, line_index: usize, weight_limit: f64) -> [f64; 6] {
+        match self.model.line_element_swept_bounding_box(line_index, weight_limit) {
+            Some([min_point, max_point]) => [
+                min_point[0], min_point[1], min_point[2],
+                max_point[0], max_point[1], max_point[2]
+            ],
+            None => [
+                f64::INFINITY, f64::INFINITY, f64::INFINITY,
+                f64::NEG_INFINITY, f64::NEG_INFINITY, f64::NEG_INFINITY
+            ]
+        }
+    }
+
+    /// Returns the projection weight from each line element on the wing with the input index at
+    /// the centers of the input cells, as a sparse list sorted by the index of the cell in 
+    /// `cell_ids`. Only weights above the weight limit are included. The line indices are global.
+    pub fn wing_line_element_weights_at_cells(
+        &self,
+        wing_index: usize,
+        cell_centers: &[f64],
+        cell_ids: &[i32],
+        weight_limit: f64
+    ) -> Vec<ffi::LineElementWeight> {
+        self.wing_line_element_weights_at_cells_in_precision::<f64>(
+            wing_index, cell_centers, cell_ids, weight_limit
+        )
+    }
+
+    /// Same as [CppActuatorLine::wing_line_element_weights_at_cells], but with the weights 
+    /// evaluated in single precision, for storage in single precision
+    pub fn wing_line_element_weights_at_cells_single(
+        &self,
+        wing_index: usize,
+        cell_centers: &[f64],
+        cell_ids: &[i32],
+        weight_limit: f64
+    ) -> Vec<ffi::LineElementWeight> {
+        self.wing_line_element_weights_at_cells_in_precision::<f32>(
+            wing_index, cell_centers, cell_ids, weight_limit
+        )
+    }
+
+    fn wing_line_element_weights_at_cells_in_precision<W: WeightPrecision>(
+        &self,
+        wing_index: usize,
+        cell_centers: &[f64],
+        cell_ids: &[i32],
+        weight_limit: f64
+    ) -> Vec<ffi::LineElementWeight> {
+        let nr_cells = cell_ids.len();
+
+        let line_indices = self.model.line_force_model.wing_indices[wing_index].clone();
+        let nr_wing_lines = line_indices.len();
+
+        // The swept boxes contain all points where the weight from a single line element exceeds 
+        // the weight limit divided by the number of line elements, for any wing angle
+        let box_weight_limit = weight_limit * self.model.line_force_model.nr_span_lines() as f64;
+
+        let line_boxes: Vec<Option<[SpatialVector; 2]>> = line_indices.clone()
+            .map(|line_index| {
+                self.model.line_element_swept_bounding_box(line_index, box_weight_limit)
+            })
+            .collect();
+
+        let mut weights = Vec::with_capacity(nr_cells);
+
+        let mut points = PointBlock::default();
+
+        // The weights for all line elements on the wing in a block, stored line element by line 
+        // element, and whether each line element can contribute to the block at all
+        let mut block_weights = vec![W::default(); nr_wing_lines * POINT_BLOCK_SIZE];
+        let mut line_is_active = vec![false; nr_wing_lines];
+
+        for start in (0..nr_cells).step_by(POINT_BLOCK_SIZE) {
+            let end = (start + POINT_BLOCK_SIZE).min(nr_cells);
+            let block_size = end - start;
+
+            points.gather(cell_centers, cell_ids[start..end].iter().copied());
+
+            let block_box = points.bounding_box();
+
+            for (local_index, line_index) in line_indices.clone().enumerate() {
+                line_is_active[local_index] = line_boxes[local_index]
+                    .is_some_and(|line_box| boxes_overlap(&line_box, &block_box));
+
+                if !line_is_active[local_index] {
+                    continue;
+                }
+
+                W::line_segment_projection_weights(
+                    &self.model,
+                    line_index,
+                    &points,
+                    &mut block_weights[local_index * block_size..(local_index + 1) * block_size]
+                );
+            }
+
+            for i in 0..block_size {
+                for (local_index, line_index) in line_indices.clone().enumerate() {
+                    if !line_is_active[local_index] {
+                        continue;
+                    }
+
+                    let weight: f64 = block_weights[local_index * block_size + i].into();
+
+                    if weight > weight_limit {
+                        weights.push(
+                            ffi::LineElementWeight {
+                                point_index: start + i,
+                                line_index,
+                                weight
+                            }
+                        );
+                    }
+                }
+            }
+        }
+
+        weights
+    }
+
+    /// Computes the body force in each of the input cells when the force from each line element is
+    /// realigned to the local velocity in the cell. The projection is given as rows of a sparse
+    /// matrix in compressed row format, where `row_offsets` has one more value than `cell_ids` and
+    /// the offsets index into `line_indices` and `values`. The body forces are stored as three
+    /// consecutive values per cell.
+    pub fn realigned_body_forces_at_cells(
+        &self,
+        velocity_field: &[f64],
+        cell_ids: &[i32],
+        row_offsets: &[i32],
+        line_indices: &[i32],
+        values: &[f64],
+        body_forces: &mut [f64]
+    ) {
+        self.realigned_body_forces_at_cells_in_precision(
+            velocity_field, cell_ids, row_offsets, line_indices, values, body_forces
+        );
+    }
+
+    /// Same as [CppActuatorLine::realigned_body_forces_at_cells], but with the projection values 
+    /// stored in single precision
+    pub fn realigned_body_forces_at_cells_single(
+        &self,
+        velocity_field: &[f64],
+        cell_ids: &[i32],
+        row_offsets: &[i32],
+        line_indices: &[i32],
+        values: &[f32],
+        body_forces: &mut [f64]
+    ) {
+        self.realigned_body_forces_at_cells_in_precision(
+            velocity_field, cell_ids, row_offsets, line_indices, values, body_forces
+        );
+    }
+
+    fn realigned_body_forces_at_cells_in_precision<W: WeightPrecision>(
+        &self,
+        velocity_field: &[f64],
+        cell_ids: &[i32],
+        row_offsets: &[i32],
+        line_indices: &[i32],
+        values: &[W],
+        body_forces: &mut [f64]
+    ) {
+        let nr_rows = cell_ids.len();
+
+        assert_eq!(row_offsets.len(), nr_rows + 1);
+        assert_eq!(body_forces.len(), 3 * nr_rows);
+
+        for row in 0..nr_rows {
+            let velocity = vector_at(velocity_field, cell_ids[row] as usize);
+
+            let mut body_force = SpatialVector::default();
+
+            for k in row_offsets[row] as usize..row_offsets[row + 1] as usize {
+                body_force += self.model.force_to_project_at_cell(
+                    line_indices[k] as usize,
+                    velocity
+                ) * values[k].into();
+            }
+
+            body_forces[3 * row]     = body_force[0];
+            body_forces[3 * row + 1] = body_force[1];
+            body_forces[3 * row + 2] = body_force[2];
+        }
+    }
+
+    /// Fills the input array with the sum of the lift and drag forces to project for each line
+    /// element, stored as three consecutive values per line element. This is the force used for
+    /// all cells when the forces are not realigned to the local velocity in each cell.
+    pub fn get_sectional_forces_to_project(&self, forces: &mut [f64]) {
+        let nr_span_lines = self.model.line_force_model.nr_span_lines();
+
+        assert_eq!(forces.len(), 3 * nr_span_lines);
+
+        for line_index in 0..nr_span_lines {
+            let force = self.model.sectional_lift_forces_to_project[line_index] +
+                self.model.sectional_drag_forces_to_project[line_index];
+
+            forces[3 * line_index]     = force[0];
+            forces[3 * line_index + 1] = force[1];
+            forces[3 * line_index + 2] = force[2];
+        }
+    }
+
+    /// Fills the input array with both the lift and drag forces to project for each line element,
+    /// stored as six consecutive values per line element, where the lift comes first. This is all 
+    /// the force data needed to project the forces, so that the model only needs to be solved on
+    /// one processor, and the result shared with the others.
+    pub fn get_sectional_lift_and_drag_forces_to_project(&self, forces: &mut [f64]) {
+        let nr_span_lines = self.model.line_force_model.nr_span_lines();
+
+        assert_eq!(forces.len(), 6 * nr_span_lines);
+
+        for line_index in 0..nr_span_lines {
+            let lift_force = self.model.sectional_lift_forces_to_project[line_index];
+            let drag_force = self.model.sectional_drag_forces_to_project[line_index];
+
+            for i in 0..3 {
+                forces[6 * line_index + i]     = lift_force[i];
+                forces[6 * line_index + 3 + i] = drag_force[i];
+            }
+        }
+    }
+
+    /// Sets the lift and drag forces to project from an array with the same layout as in 
+    /// [CppActuatorLine::get_sectional_lift_and_drag_forces_to_project].
+    pub fn set_sectional_lift_and_drag_forces_to_project(&mut self, forces: &[f64]) {
+        let nr_span_lines = self.model.line_force_model.nr_span_lines();
+
+        assert_eq!(forces.len(), 6 * nr_span_lines);
+
+        for line_index in 0..nr_span_lines {
+            let offset = 6 * line_index;
+
+            self.model.sectional_lift_forces_to_project[line_index] = SpatialVector::from(
+                [forces[offset], forces[offset + 1], forces[offset + 2]]
+            );
+
+            self.model.sectional_drag_forces_to_project[line_index] = SpatialVector::from(
+                [forces[offset + 3], forces[offset + 4], forces[offset + 5]]
+            );
+        }
+    }
+
+    pub fn write_results(&mut self, folder_path: &str) {
         self.model.write_results(folder_path);
     }
+
+    /// Same as [CppActuatorLine::write_results], but the results are only queued for writing on a
+    /// background thread, so that the call returns without waiting for the file system.
+    ///
+    /// The model keeps using its own result in the next time step, so the whole result is cloned
+    /// at each call. The cost of this is proportional to the number of line elements, and is 
+    /// small compared to the formatting and writing that is moved to the background thread, but 
+    /// it is still paid on the calling thread.
+    pub fn write_results_asynchronously(&mut self, folder_path: &str) {
+        let Some(simulation_result) = &self.model.simulation_result else {
+            return;
+        };
+
+        let writer_is_valid = self.result_writer.as_ref()
+            .is_some_and(|writer| writer.folder_path() == folder_path);
+
+        if !writer_is_valid {
+            // Dropping the old writer first finishes the writing to the old folder
+            self.result_writer = None;
+            self.result_writer = Some(
+                ResultWriter::new(folder_path, self.model.write_binary_results)
+            );
+        }
+
+        let write_full_result = !self.model.write_binary_results &&
+            self.model.current_iteration % self.model.write_iterations_full_result == 0;
+
+        if let Some(writer) = &self.result_writer {
+            writer.write(simulation_result.clone(), self.model.current_iteration, write_full_result);
+        }
+    }
+
+    pub fn write_restart_state(&self, file_path: &str) {
+        self.model.write_restart_state(file_path)
+    }
+
+    /// Applies the restart state in the input file. Returns false, and leaves the model unchanged,
+    /// if the file does not exist or does not fit the model.
+    pub fn read_restart_state(&mut self, file_path: &str) -> bool {
+        if !std::path::Path::new(file_path).exists() {
+            return false;
+        }
+
+        match self.model.read_restart_state(file_path) {
+            Ok(()) => true,
+            Err(error) => {
+                eprintln!("Could not use the restart state in {}: {}", file_path, error);
+
+                false
+            }
+        }
+    }
+
+    pub fn geometry_hash(&self) -> u64 {
+        self.model.geometry_hash()
+    }
+
+    /// Stores the current position of the model as the reference for the body frame motion
+    pub fn set_body_frame_reference(&mut self) {
+        self.model.set_body_frame_reference();
+    }
+
+    /// Moves the model with a rigid transformation relative to the reference. The rotation matrix
+    /// is given as nine values in row major order.
+    pub fn move_with_body_frame(
+        &mut self, 
+        rotation_matrix: &[f64; 9], 
+        translation: &[f64; 3], 
+        time_step: f64
+    ) {
+        let rotation_matrix = [
+            [rotation_matrix[0], rotation_matrix[1], rotation_matrix[2]],
+            [rotation_matrix[3], rotation_matrix[4], rotation_matrix[5]],
+            [rotation_matrix[6], rotation_matrix[7], rotation_matrix[8]],
+        ];
+
+        self.model.move_with_body_frame(
+            rotation_matrix, SpatialVector::from(*translation), time_step
+        );
+    }
 }
@@ -0,0 +1,168 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see seperate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+//! Writer that exports results from the actuator line model on a background thread, so that the
+//! time stepping in the CFD solver does not have to wait for the file system.
+
+use std::fs::{self, File, OpenOptions};
+use std::io::{BufWriter, Write};
+use std::path::{Path, PathBuf};
+use std::sync::mpsc::{sync_channel, Receiver, SyncSender};
+use std::thread::{self, JoinHandle};
+
+use stormbird::common_utils::prelude::SimulationResult;
+use stormbird::common_utils::results::result_stream::LazyResultStream;
+use stormbird::actuator_line::ActuatorLine;
+
+/// A single result that should be written to file
+struct ResultJob {
+    simulation_result: SimulationResult,
+    iteration: usize,
+    write_full_result: bool,
+}
+
+/// Writes the same files as [stormbird::actuator_line::ActuatorLine::write_results], but on a
+/// separate thread. The force file, and the binary result stream if it is used, are kept open
+/// between each write. The files are only flushed when all queued results are written, and when
+/// the writer is dropped, rather than after every record.
+///
+/// The results are sent to the thread through a bounded queue. The caller will therefore only
+/// wait if the writer falls behind by more than the queue capacity, which limits the memory usage
+/// if the file system is slower than the simulation. All queued results are written when the
+/// writer is dropped.
+pub struct ResultWriter {
+    folder_path: String,
+    sender: Option<SyncSender<ResultJob>>,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl ResultWriter {
+    /// Maximum number of results waiting to be written
+    const QUEUE_CAPACITY: usize = 64;
+
+    pub fn new(folder_path: &str, write_binary_results: bool) -> Self {
+        let (sender, receiver) = sync_channel(Self::QUEUE_CAPACITY);
+
+        let thread_folder_path = PathBuf::from(folder_path);
+
+        let thread = thread::Builder::new()
+            .name("stormbird_result_writer".to_string())
+            .spawn(move || {
+                Self::write_loop(&thread_folder_path, receiver, write_binary_results)
+            })
+            .expect("Failed to start the result writer thread");
+
+        Self {
+            folder_path: folder_path.to_string(),
+            sender: Some(sender),
+            thread: Some(thread),
+        }
+    }
+
+    pub fn folder_path(&self) -> &str {
+        &self.folder_path
+    }
+
+    /// Queues the input result for writing.
+    pub fn write(&self, simulation_result: SimulationResult, iteration: usize, write_full_result: bool) {
+        if let Some(sender) = &self.sender {
+            let job = ResultJob {
+                simulation_result,
+                iteration,
+                write_full_result
+            };
+
+            // The thread only stops if it has failed, in which case the error is already reported
+            let _ = sender.send(job);
+        }
+    }
+
+    fn write_loop(folder_path: &Path, receiver: Receiver<ResultJob>, write_binary_results: bool) {
+        let mut force_file: Option<BufWriter<File>> = None;
+        let mut result_stream = LazyResultStream::default();
+
+        let result_stream_path = folder_path.join(ActuatorLine::RESULT_STREAM_FILE_NAME);
+
+        // Waits for the next result, and then writes all results in the queue before flushing
+        while let Ok(first_job) = receiver.recv() {
+            let mut next_job = Some(first_job);
+
+            while let Some(job) = next_job {
+                if force_file.is_none() {
+                    force_file = Some(Self::open_force_file(folder_path, &job.simulation_result));
+                }
+
+                let (_, data) = job.simulation_result.as_reduced_flatten_csv_string();
+
+                if let Some(file) = force_file.as_mut() {
+                    writeln!(file, "{}", data).unwrap();
+                }
+
+                if write_binary_results {
+                    result_stream.write(&result_stream_path, &job.simulation_result);
+                }
+
+                if job.write_full_result {
+                    Self::write_full_result(folder_path, &job);
+                }
+
+                next_job = receiver.try_recv().ok();
+            }
+
+            if let Some(file) = force_file.as_mut() {
+                file.flush().unwrap();
+            }
+
+            result_stream.flush();
+        }
+    }
+
+    fn write_full_result(folder_path: &Path, job: &ResultJob) {
+        let result_folder_path = folder_path.join("stormbird_full_results");
+        fs::create_dir_all(&result_folder_path).unwrap();
+
+        let json_string = serde_json::to_string_pretty(&job.simulation_result).unwrap();
+
+        fs::write(
+            result_folder_path.join(format!("full_results_{}.json", job.iteration)),
+            json_string
+        ).unwrap();
+    }
+
+    /// Opens the force file for appending, and writes the header if the file is new.
+    fn open_force_file(folder_path: &Path, simulation_result: &SimulationResult) -> BufWriter<File> {
+        fs::create_dir_all(folder_path).unwrap();
+
+        let force_file_path = folder_path.join("stormbird_forces.csv");
+
+        let file_exists = force_file_path.exists();
+
+        let file = OpenOptions::new()
+            .create(true)
+            .append(true)
+            .open(&force_file_path)
+            .unwrap();
+
+        let mut file = BufWriter::new(file);
+
+        if !file_exists {
+            let (header, _) = simulation_result.as_reduced_flatten_csv_string();
+
+            writeln!(file, "{}", header).unwrap();
+        }
+
+        file
+    }
+}
+
+impl Drop for ResultWriter {
+    fn drop(&mut self) {
+        // Closing the queue stops the thread after the remaining results are written
+        self.sender = None;
+
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
@@ -0,0 +1,306 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+///
+/// Benchmark of the actuator line model on a synthetic box mesh, without running a flow solver. 
+/// The mesh is generated in memory with uniform hexahedral cells, and the model is called in the
+/// same way as from the momentum equation in a solver, with a uniform velocity field. The timing 
+/// of each phase is reported by the model itself at the end of the run.
+///
+/// Must be run from a case directory with a `system/controlDict`, which gives the time step, and
+/// the `system/stormbird_actuator_line.json` input file. Run with `-help` to see the options.
+///
+
+#include "fvCFD.H"
+#include "wallPolyPatch.H"
+
+#include <chrono>
+#include <cmath>
+
+#include "actuator_line.hpp"
+
+namespace {
+    Foam::face quad(
+        const Foam::label a, 
+        const Foam::label b, 
+        const Foam::label c, 
+        const Foam::label d
+    ) {
+        Foam::face f(4);
+
+        f[0] = a;
+        f[1] = b;
+        f[2] = c;
+        f[3] = d;
+
+        return f;
+    }
+
+    /// Creates a mesh of the input box with uniform hexahedral cells, with approximately the 
+    /// input number of cells, and a single wall patch for all boundary faces
+    Foam::autoPtr<Foam::fvMesh> create_box_mesh(
+        const Foam::Time& run_time, 
+        const Foam::boundBox& box, 
+        const Foam::label target_nr_cells
+    ) {
+        using namespace Foam;
+
+        const vector span = box.span();
+
+        const scalar spacing = std::cbrt(span.x() * span.y() * span.z() / target_nr_cells);
+
+        const label nx = Foam::max(label(std::round(span.x() / spacing)), 1);
+        const label ny = Foam::max(label(std::round(span.y() / spacing)), 1);
+        const label nz = Foam::max(label(std::round(span.z() / spacing)), 1);
+
+        const vector cell_size(span.x() / nx, span.y() / ny, span.z() / nz);
+
+        auto point_index = [&](label i, label j, label k) {
+            return i + (nx + 1) * (j + (ny + 1) * k);
+        };
+
+        auto cell_index = [&](label i, label j, label k) {
+            return i + nx * (j + ny * k);
+        };
+
+        // Faces normal to each direction, at the lower corner of cell (i, j, k), oriented in the
+        // positive direction
+        auto x_face = [&](label i, label j, label k) {
+            return quad(
+                point_index(i, j, k), point_index(i, j + 1, k), 
+                point_index(i, j + 1, k + 1), point_index(i, j, k + 1)
+            );
+        };
+
+        auto y_face = [&](label i, label j, label k) {
+            return quad(
+                point_index(i, j, k), point_index(i, j, k + 1), 
+                point_index(i + 1, j, k + 1), point_index(i + 1, j, k)
+            );
+        };
+
+        auto z_face = [&](label i, label j, label k) {
+            return quad(
+                point_index(i, j, k), point_index(i + 1, j, k), 
+                point_index(i + 1, j + 1, k), point_index(i, j + 1, k)
+            );
+        };
+
+        pointField points((nx + 1) * (ny + 1) * (nz + 1));
+
+        for (label k = 0; k <= nz; k++) {
+            for (label j = 0; j <= ny; j++) {
+                for (label i = 0; i <= nx; i++) {
+                    points[point_index(i, j, k)] = 
+                        box.min() + cmptMultiply(vector(i, j, k), cell_size);
+                }
+            }
+        }
+
+        const label nr_internal_faces = 
+            (nx - 1) * ny * nz + nx * (ny - 1) * nz + nx * ny * (nz - 1);
+        const label nr_boundary_faces = 2 * (ny * nz + nx * nz + nx * ny);
+
+        DynamicList<face> faces(nr_internal_faces + nr_boundary_faces);
+        DynamicList<label> owner(nr_internal_faces + nr_boundary_faces);
+        DynamicList<label> neighbour(nr_internal_faces);
+
+        // The internal faces are added in upper triangular order, which is required by OpenFOAM
+        for (label k = 0; k < nz; k++) {
+            for (label j = 0; j < ny; j++) {
+                for (label i = 0; i < nx; i++) {
+                    const label cell = cell_index(i, j, k);
+
+                    if (i < nx - 1) {
+                        faces.append(x_face(i + 1, j, k));
+                        owner.append(cell);
+                        neighbour.append(cell_index(i + 1, j, k));
+                    }
+
+                    if (j < ny - 1) {
+                        faces.append(y_face(i, j + 1, k));
+                        owner.append(cell);
+                        neighbour.append(cell_index(i, j + 1, k));
+                    }
+
+                    if (k < nz - 1) {
+                        faces.append(z_face(i, j, k + 1));
+                        owner.append(cell);
+                        neighbour.append(cell_index(i, j, k + 1));
+                    }
+                }
+            }
+        }
+
+        // The boundary faces point out of the domain
+        for (label k = 0; k < nz; k++) {
+            for (label j = 0; j < ny; j++) {
+                faces.append(x_face(0, j, k).reverseFace());
+                owner.append(cell_index(0, j, k));
+
+                faces.append(x_face(nx, j, k));
+                owner.append(cell_index(nx - 1, j, k));
+            }
+        }
+
+        for (label k = 0; k < nz; k++) {
+            for (label i = 0; i < nx; i++) {
+                faces.append(y_face(i, 0, k).reverseFace());
+                owner.append(cell_index(i, 0, k));
+
+                faces.append(y_face(i, ny, k));
+                owner.append(cell_index(i, ny - 1, k));
+            }
+        }
+
+        for (label j = 0; j < ny; j++) {
+            for (label i = 0; i < nx; i++) {
+                faces.append(z_face(i, j, 0).reverseFace());
+                owner.append(cell_index(i, j, 0));
+
+                faces.append(z_face(i, j, nz));
+                owner.append(cell_index(i, j, nz - 1));
+            }
+        }
+
+        autoPtr<fvMesh> mesh(
+            new fvMesh(
+                IOobject(
+                    polyMesh::defaultRegion,
+                    run_time.constant(),
+                    run_time,
+                    IOobject::NO_READ,
+                    IOobject::NO_WRITE
+                ),
+                std::move(points),
+                faceList(std::move(faces)),
+                labelList(std::move(owner)),
+                labelList(std::move(neighbour))
+            )
+        );
+
+        List<polyPatch*> patches(1);
+
+        patches[0] = new wallPolyPatch(
+            "walls",
+            nr_boundary_faces,
+            nr_internal_faces,
+            0,
+            mesh().boundaryMesh(),
+            wallPolyPatch::typeName
+        );
+
+        mesh().addFvPatches(patches);
+
+        Info<< "Created box mesh with " << nx << " x " << ny << " x " << nz << " = " 
+            << mesh().nCells() << " cells" << nl << endl;
+
+        return mesh;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    argList::addNote(
+        "Times the phases of the actuator line model on a synthetic box mesh, without a flow "
+        "solver"
+    );
+
+    argList::noParallel();
+
+    argList::addOption("cells", "label", "Approximate number of cells (default: 1000000)");
+    argList::addOption("min", "vector", "Lower corner of the mesh (default: (-10 -10 -10))");
+    argList::addOption("max", "vector", "Upper corner of the mesh (default: (10 10 10))");
+    argList::addOption("velocity", "vector", "Uniform velocity in the mesh (default: (8 0 0))");
+    argList::addOption("steps", "label", "Number of time steps (default: 20)");
+    argList::addOption("threads", "label", "Number of threads (default: 1)");
+    argList::addBoolOption(
+        "rebuild",
+        "Recompute the projection and sampling data at every time step, as when the sails are "
+        "trimmed by a controller"
+    );
+
+    #include "setRootCase.H"
+    #include "createTime.H"
+
+    const label nr_cells = args.getOrDefault<label>("cells", 1000000);
+    const label nr_steps = Foam::max(args.getOrDefault<label>("steps", 20), 1);
+    const label nr_threads = args.getOrDefault<label>("threads", 1);
+    const bool rebuild = args.found("rebuild");
+
+    const boundBox box(
+        args.getOrDefault<vector>("min", vector(-10, -10, -10)),
+        args.getOrDefault<vector>("max", vector(10, 10, 10))
+    );
+
+    autoPtr<fvMesh> mesh_ptr = create_box_mesh(runTime, box, nr_cells);
+    fvMesh& mesh = mesh_ptr();
+
+    volVectorField U(
+        IOobject("U", runTime.timeName(), mesh, IOobject::NO_READ, IOobject::NO_WRITE),
+        mesh,
+        dimensionedVector(
+            "U", dimVelocity, args.getOrDefault<vector>("velocity", vector(8, 0, 0))
+        )
+    );
+
+    // The same entries as in the fvOptions dictionary of a case. The timing is reported after 
+    // the last step.
+    dictionary option_dict;
+
+    option_dict.add("type", word("actuatorLine"));
+    option_dict.add("selectionMode", word("all"));
+    option_dict.add("fields", wordList(1, word("U")));
+    option_dict.add("nThreads", nr_threads);
+    option_dict.add("timingInterval", nr_steps);
+
+    auto setup_start = std::chrono::steady_clock::now();
+
+    fv::ActuatorLine actuator_line("actuatorLine", "actuatorLine", option_dict, mesh);
+
+    std::chrono::duration<double> setup_time = std::chrono::steady_clock::now() - setup_start;
+
+    fvMatrix<vector> eqn(U, dimVelocity*dimVolume/dimTime);
+
+    std::chrono::duration<double> first_step_time(0.0);
+    std::chrono::duration<double> step_time(0.0);
+
+    for (label step = 0; step < nr_steps; step++) {
+        ++runTime;
+
+        if (rebuild && step > 0) {
+            actuator_line.request_geometry_update();
+        }
+
+        eqn.source() = Zero;
+
+        auto step_start = std::chrono::steady_clock::now();
+
+        actuator_line.addSup(eqn, 0);
+
+        std::chrono::duration<double> duration = std::chrono::steady_clock::now() - step_start;
+
+        // The first step includes the initial search for the relevant cells
+        if (step == 0) {
+            first_step_time = duration;
+        } else {
+            step_time += duration;
+        }
+    }
+
+    Info<< "Actuator line benchmark with " << mesh.nCells() << " cells and " 
+        << nr_threads << " threads" << nl
+        << "    setup [s]: " << setup_time.count() << nl
+        << "    first step [s]: " << first_step_time.count() << nl;
+
+    if (nr_steps > 1) {
+        Info<< "    average of the other steps [s]: " 
+            << step_time.count() / (nr_steps - 1) << nl;
+    }
+
+    Info<< "    total projected force: " << gSum(eqn.source()) << nl << endl;
+
+    Info<< "End" << nl << endl;
+
+    return 0;
+}
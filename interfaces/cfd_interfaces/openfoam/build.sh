@@ -13,3 +13,6 @@ cxxbridge $CPP_AL_FOLDER/src/lib.rs --header > src/cpp_actuator_line.hpp
 cxxbridge $CPP_AL_FOLDER/src/lib.rs > src/cpp_actuator_line.cpp
 
 wmake src
+
+# Optional micro-benchmark of the actuator line phases on a synthetic mesh
+wmake benchmark
@@ -5,12 +5,16 @@ cp -r 0.org 0
 blockMesh
 snappyHexMesh -overwrite
 
-decomposePar
+if [ "$number_of_threads" -gt 1 ]; then
+    decomposePar
 
-mpirun -np $number_of_threads pimpleFoam -parallel
+    mpirun -np $number_of_threads pimpleFoam -parallel | tee log.pimpleFoam
 
-reconstructPar
+    reconstructPar
 
-rm -fr proc*
+    rm -fr proc*
+else
+    pimpleFoam | tee log.pimpleFoam
+fi
 
 postProcess -func Q
\ No newline at end of file
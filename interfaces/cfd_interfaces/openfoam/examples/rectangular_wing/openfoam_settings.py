@@ -6,11 +6,24 @@ from dataclasses import dataclass
 @dataclass(kw_only=True, slots=True)
 class OpenFOAMSettings:
     number_of_threads: int | None = None
+    end_time: float = 20.0
+    mesh_scale: float = 1.0
+    timing_interval: int = 0
 
     def __post_init__(self):
         if self.number_of_threads is None:
             self.number_of_threads = int(os.cpu_count() / 2)
 
+    @property
+    def block_cells(self) -> tuple[int, int, int]:
+        '''
+        Number of cells in each direction in the background mesh. The mesh scale is applied in all 
+        directions, so that the number of cells scales with the mesh scale cubed.
+        '''
+        base_cells = (48, 32, 16)
+
+        return tuple(max(round(nr_cells * self.mesh_scale), 1) for nr_cells in base_cells)
+
     def write_to_file(self, path: str) -> None:
         with open(path, 'w') as f:
             for slot in self.__slots__:
@@ -18,6 +31,8 @@ class OpenFOAMSettings:
 
                 f.write(f"{slot} {value};\n")
 
+            f.write("block_cells ({} {} {});\n".format(*self.block_cells))
+
     def set_as_environmental_variables(self):
         for slot in self.__slots__:
             value = getattr(self, slot)
@@ -25,7 +40,12 @@ class OpenFOAMSettings:
             os.environ[slot] = str(value)
 
 class FolderPaths():
-    def __init__(self, angle_of_attack_deg):
+    def __init__(self, angle_of_attack_deg, case_name: str | None = None):
         self.base_folder = Path("base_folder")
         self.foam_run = Path(os.environ['FOAM_RUN'])
-        self.run_folder = self.foam_run / 'stormbird_rectangular_wing_example' / f'aoa_{angle_of_attack_deg}'
+        self.example_folder = self.foam_run / 'stormbird_rectangular_wing_example'
+
+        if case_name is None:
+            case_name = f'aoa_{angle_of_attack_deg}'
+
+        self.run_folder = self.example_folder / case_name
@@ -1,6 +1,6 @@
-
 import shutil
 import subprocess
+import re
 import pandas as pd
 import matplotlib.pyplot as plt
 import argparse
@@ -9,51 +9,194 @@ from stormbird_settings import StormbirdSettings
 from openfoam_settings import OpenFOAMSettings, FolderPaths
 
 
+def run_case(
+    stormbird_settings: StormbirdSettings, 
+    openfoam_settings: OpenFOAMSettings, 
+    folder_paths: FolderPaths
+) -> None:
+    '''
+    Sets up a case from the base folder in the run folder, and runs it
+    '''
+    if folder_paths.run_folder.exists():
+        shutil.rmtree(folder_paths.run_folder)
 
-if __name__ == '__main__':
-    parser = argparse.ArgumentParser()
-    parser.add_argument("--angle-of-attack", type=float, required=True, help="Angle of attacks to simulate")
-    parser.add_argument("--use-ll-correction", action='store_true')
+    shutil.copytree(folder_paths.base_folder, folder_paths.run_folder)
 
-    args = parser.parse_args()
+    stormbird_settings.write_actuator_line_setup_to_file(folder_paths.run_folder / 'system' /'stormbird_actuator_line.json')
+    stormbird_settings.write_dimensions(folder_paths.run_folder / 'dimensions.txt')
+
+    openfoam_settings.write_to_file(folder_paths.run_folder / "simulation_settings.txt")
+    openfoam_settings.set_as_environmental_variables()
+
+    subprocess.run(['bash run.sh'], cwd=folder_paths.run_folder, shell=True)
+
+
+def read_execution_times(log_path) -> dict[float, float]:
+    '''
+    Reads the accumulated wall clock time at each time step from a pimpleFoam log. The value 
+    reported after "Time = t" is the time spent up to and including that time step.
+    '''
+    execution_times = {}
+
+    time = None
+    with open(log_path, 'r') as f:
+        for line in f:
+            time_match = re.match(r'^Time = (\S+)', line)
+
+            if time_match is not None:
+                time = float(time_match.group(1))
+
+                continue
+
+            execution_match = re.match(r'^ExecutionTime = (\S+) s', line)
+
+            if execution_match is not None and time is not None:
+                execution_times[time] = float(execution_match.group(1))
+
+    return execution_times
+
+
+def benchmark_result(folder_paths: FolderPaths, nr_ranks: int, mesh_scale: float) -> dict:
+    '''
+    Collects the total run time of a benchmark case, and the share of it spent in the actuator line,
+    based on the last row in the actuator line timing file. As the processors wait for each other in 
+    the collective operations, the maximum time over the processors is used for each phase.
+    '''
+    execution_times = read_execution_times(folder_paths.run_folder / 'log.pimpleFoam')
+
+    timing_df = pd.read_csv(folder_paths.run_folder / 'postProcessing' / 'actuatorLineTiming.csv')
+
+    last_row = timing_df.iloc[-1]
+
+    report_time = float(last_row['time'])
+
+    phase_columns = [
+        column for column in timing_df.columns 
+        if column.endswith('_max') and not column.endswith('Cells_max')
+    ]
+
+    actuator_line_time = sum(float(last_row[column]) for column in phase_columns)
 
-    result_data = []
+    # The timing file can be written on an earlier time step than the last one, if the number of
+    # time steps is not a multiple of the timing interval.
+    closest_time = min(execution_times.keys(), key=lambda time: abs(time - report_time))
 
-    angle = args.angle_of_attack
+    return {
+        'nr_ranks': nr_ranks,
+        'mesh_scale': mesh_scale,
+        'execution_time': execution_times[max(execution_times.keys())],
+        'actuator_line_time': actuator_line_time,
+        'actuator_line_share': actuator_line_time / execution_times[closest_time],
+        'projection_cells_max': float(last_row['projectionCells_max']),
+        'projection_cells_avg': float(last_row['projectionCells_avg']),
+    }
 
+
+def run_benchmark(args) -> None:
+    '''
+    Runs the example with a range of ranks, and reports the parallel efficiency. For strong scaling
+    each mesh scale is run with all the ranks. For weak scaling, the mesh scale is increased with the
+    number of ranks so that the number of cells per rank stays approximately constant.
+    '''
     stormbird_settings = StormbirdSettings(
-        angle_of_attack_deg=angle,
+        angle_of_attack_deg=args.angle_of_attack,
         use_ll_correction=args.use_ll_correction
     )
 
-    folder_paths = FolderPaths(angle_of_attack_deg=angle)
+    reference_ranks = args.ranks[0]
 
-    if folder_paths.run_folder.exists():
-        shutil.rmtree(folder_paths.run_folder)
+    cases = []
+    for base_scale in args.mesh_scales:
+        for nr_ranks in args.ranks:
+            if args.scaling == 'weak':
+                mesh_scale = base_scale * (nr_ranks / reference_ranks)**(1.0 / 3.0)
+            else:
+                mesh_scale = base_scale
 
-    shutil.copytree(folder_paths.base_folder, folder_paths.run_folder)
+            cases.append((base_scale, nr_ranks, mesh_scale))
 
-    stormbird_settings.write_actuator_line_setup_to_file(folder_paths.run_folder / 'system' /'stormbird_actuator_line.json')
-    stormbird_settings.write_dimensions(folder_paths.run_folder / 'dimensions.txt')
+    results = []
+    for base_scale, nr_ranks, mesh_scale in cases:
+        folder_paths = FolderPaths(
+            angle_of_attack_deg=args.angle_of_attack,
+            case_name=f'scaling/{args.scaling}_scale_{base_scale}_ranks_{nr_ranks}'
+        )
 
-    openfoam_settings = OpenFOAMSettings()
+        openfoam_settings = OpenFOAMSettings(
+            number_of_threads=nr_ranks,
+            end_time=args.end_time,
+            mesh_scale=mesh_scale,
+            timing_interval=args.timing_interval
+        )
 
-    openfoam_settings.write_to_file(folder_paths.run_folder / "simulation_settings.txt")
-    openfoam_settings.set_as_environmental_variables()
+        run_case(stormbird_settings, openfoam_settings, folder_paths)
 
-    subprocess.run(['bash run.sh'], cwd=folder_paths.run_folder, shell=True)
+        result = benchmark_result(folder_paths, nr_ranks, mesh_scale)
+        result['base_scale'] = base_scale
+
+        results.append(result)
+
+    report_df = pd.DataFrame(results)
+
+    reference_df = report_df[report_df['nr_ranks'] == reference_ranks].set_index('base_scale')
+
+    reference_time = report_df['base_scale'].map(reference_df['execution_time'])
+
+    if args.scaling == 'weak':
+        report_df['efficiency'] = reference_time / report_df['execution_time']
+    else:
+        report_df['efficiency'] = (
+            reference_time * reference_ranks / (report_df['execution_time'] * report_df['nr_ranks'])
+        )
+
+    report_folder = FolderPaths(angle_of_attack_deg=args.angle_of_attack).example_folder / 'scaling'
+    report_folder.mkdir(parents=True, exist_ok=True)
+
+    report_df.to_csv(report_folder / f'{args.scaling}_scaling_report.csv', index=False)
+
+    print(report_df.to_string(index=False))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--angle-of-attack", type=float, required=True, help="Angle of attacks to simulate")
+    parser.add_argument("--use-ll-correction", action='store_true')
+    parser.add_argument("--benchmark", action='store_true', help="Run a scaling benchmark instead of a single case")
+    parser.add_argument("--ranks", type=int, nargs='+', default=[1, 2, 4, 8], help="Number of MPI ranks in the benchmark. The first value is the reference")
+    parser.add_argument("--mesh-scales", type=float, nargs='+', default=[1.0], help="Scale factors for the number of cells in each direction of the background mesh")
+    parser.add_argument("--scaling", choices=['strong', 'weak'], default='strong')
+    parser.add_argument("--end-time", type=float, default=2.0, help="End time for the benchmark cases")
+    parser.add_argument("--timing-interval", type=int, default=10, help="Time steps between each write of the actuator line timing file")
+
+    args = parser.parse_args()
+
+    if args.benchmark:
+        run_benchmark(args)
+    else:
+        angle = args.angle_of_attack
+
+        stormbird_settings = StormbirdSettings(
+            angle_of_attack_deg=angle,
+            use_ll_correction=args.use_ll_correction
+        )
+
+        folder_paths = FolderPaths(angle_of_attack_deg=angle)
+
+        openfoam_settings = OpenFOAMSettings()
+
+        run_case(stormbird_settings, openfoam_settings, folder_paths)
 
-    forces_df = pd.read_csv(folder_paths.run_folder / 'postProcessing' / 'stormbird_forces.csv')
+        forces_df = pd.read_csv(folder_paths.run_folder / 'postProcessing' / 'stormbird_forces.csv')
 
-    force_x = forces_df['force_0.x'].to_numpy() / stormbird_settings.force_factor
-    force_y = forces_df['force_0.y'].to_numpy() / stormbird_settings.force_factor
+        force_x = forces_df['force_0.x'].to_numpy() / stormbird_settings.force_factor
+        force_y = forces_df['force_0.y'].to_numpy() / stormbird_settings.force_factor
 
-    plt.plot(forces_df['time'], force_x, label="x")
-    plt.plot(forces_df['time'], force_y, label="y")
+        plt.plot(forces_df['time'], force_x, label="x")
+        plt.plot(forces_df['time'], force_y, label="y")
 
-    print('Last force, x', force_x[-1])
-    print('Last force, y', force_y[-1])
+        print('Last force, x', force_x[-1])
+        print('Last force, y', force_y[-1])
 
-    plt.legend()
+        plt.legend()
 
-    plt.savefig(folder_paths.run_folder / "force_plot.png", dpi=300, bbox_inches='tight')
+        plt.savefig(folder_paths.run_folder / "force_plot.png", dpi=300, bbox_inches='tight')
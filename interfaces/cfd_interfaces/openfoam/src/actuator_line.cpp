@@ -11,10 +11,32 @@
 
 #include "OFstream.H"
 
+#include <fstream>
+#include <sstream>
+
 #include "actuator_line.hpp"
+#include "actuator_line_registry.hpp"
 
 #include "cpp_actuator_line.hpp"
 
+namespace {
+    /// Allocated memory for a list, including the unused capacity of dynamic lists
+    template<class Type>
+    std::size_t list_memory(const Foam::UList<Type>& list) {
+        return list.size() * sizeof(Type);
+    }
+
+    template<class Type>
+    std::size_t list_memory(const Foam::DynamicList<Type>& list) {
+        return list.capacity() * sizeof(Type);
+    }
+
+    template<class Type>
+    std::size_t vector_memory(const std::vector<Type>& values) {
+        return values.capacity() * sizeof(Type);
+    }
+}
+
 namespace Foam {
     namespace fv {
         defineTypeNameAndDebug(ActuatorLine, 0);
@@ -22,6 +44,21 @@ namespace Foam {
     }
 }
 
+const Foam::Enum<Foam::fv::ActuatorLine::CouplingMode> 
+Foam::fv::ActuatorLine::coupling_mode_names({
+    {CouplingMode::every_call, "everyCall"},
+    {CouplingMode::first_call, "firstCall"},
+    {CouplingMode::final_iteration, "finalIteration"},
+    {CouplingMode::resample_every_call, "resampleEveryCall"},
+});
+
+const Foam::Enum<Foam::fv::ActuatorLine::BodyForceFields> 
+Foam::fv::ActuatorLine::body_force_fields_names({
+    {BodyForceFields::dense, "dense"},
+    {BodyForceFields::sparse, "sparse"},
+    {BodyForceFields::none, "none"},
+});
+
 // Constructor
 Foam::fv::ActuatorLine::ActuatorLine(
     const word& name,
@@ -33,41 +70,116 @@ Foam::fv::ActuatorLine::ActuatorLine(
     coeffs_.readEntry("fields", fieldNames_);
     applied_.setSize(fieldNames_.size(), false);
 
-    this->model = stormbird_interface::new_actuator_line_from_file("system/stormbird_actuator_line.json");
+    this->worker_pool.resize(Foam::max(coeffs_.getOrDefault<label>("nThreads", 1), 1));
+    this->write_results_asynchronously = coeffs_.getOrDefault<bool>(
+        "writeResultsAsynchronously", false
+    );
+    this->solve_on_master_only = coeffs_.getOrDefault<bool>("solveOnMasterOnly", false);
+    this->coupling_mode = coupling_mode_names.getOrDefault(
+        "couplingMode", coeffs_, CouplingMode::every_call
+    );
+    this->timing_interval = coeffs_.getOrDefault<label>("timingInterval", 0);
+    this->restart_data = coeffs_.getOrDefault<bool>("restartData", false);
+    this->body_frame_projection = coeffs_.getOrDefault<bool>("bodyFrameProjection", false);
+    this->single_precision_weights = coeffs_.getOrDefault<bool>("singlePrecisionWeights", false);
+    this->body_force_fields = body_force_fields_names.getOrDefault(
+        "bodyForceFields", coeffs_, BodyForceFields::dense
+    );
+
+    if (coeffs_.getOrDefault<bool>("sharedRegistry", false)) {
+        this->registry = &ActuatorLineRegistry::New(mesh_);
+        this->registry->add_instance(this);
+    }
+
+    // Only the master reads the input file, and shares the content with the other processors, so
+    // that large parallel runs do not open the same file from every processor at once. Separate
+    // entries can use different input files, for instance for different sails or ships.
+    const fileName input_file_path = coeffs_.getOrDefault<fileName>(
+        "inputFile", "system/stormbird_actuator_line.json"
+    ).expand();
+
+    string model_input;
+
+    if (Pstream::master()) {
+        std::ifstream input_file(input_file_path);
+
+        if (!input_file.good()) {
+            FatalErrorInFunction
+                << "Could not read the actuator line input file " << input_file_path
+                << exit(FatalError);
+        }
+
+        std::stringstream input_stream;
+        input_stream << input_file.rdbuf();
+
+        model_input = input_stream.str();
+    }
+
+    Pstream::broadcast(model_input);
+
+    this->model = stormbird_interface::new_actuator_line_from_string(model_input);
 
-    this->body_force_field = new volVectorField(
-        IOobject(
-            "bodyForce",
-            mesh_.time().timeName(),
+    this->wing_projection_data.resize(this->model->nr_wings());
+
+    if (this->body_force_fields == BodyForceFields::dense) {
+        this->body_force_field = new volVectorField(
+            IOobject(
+                "bodyForce",
+                mesh_.time().timeName(),
+                mesh_,
+                IOobject::NO_READ,
+                IOobject::AUTO_WRITE
+            ),
             mesh_,
-            IOobject::NO_READ,
-            IOobject::AUTO_WRITE
-    ),
-        mesh_,
-        dimensionedVector("bodyForce", dimensionSet(0,0,0,0,0,0,0), vector::zero)
-    );
+            dimensionedVector("bodyForce", dimensionSet(0,0,0,0,0,0,0), vector::zero)
+        );
 
-    this->body_force_field_weight = new volScalarField(
-        IOobject(
-            "bodyForceWeight",
-            mesh_.time().timeName(),
+        this->body_force_field_weight = new volScalarField(
+            IOobject(
+                "bodyForceWeight",
+                mesh_.time().timeName(),
+                mesh_,
+                IOobject::NO_READ,
+                IOobject::AUTO_WRITE
+            ),
             mesh_,
-            IOobject::NO_READ,
-            IOobject::AUTO_WRITE
-    ),
-        mesh_,
-        dimensionedScalar("bodyForceWeight", dimensionSet(0,0,0,0,0,0,0), 0.0)
-    );
+            dimensionedScalar("bodyForceWeight", dimensionSet(0,0,0,0,0,0,0), 0.0)
+        );
+    }
+
+    if (this->restart_data) {
+        this->read_restart_data();
+    }
+
+    const bool write_cell_weights = coeffs_.getOrDefault<bool>("writeCellWeights", false);
+
+    // Optionally compute the relevant cells right away, and write weights that can be used when 
+    // decomposing the mesh. This is also done when the data is kept in the body frame, so that 
+    // the reference is taken from the mesh before it starts to move.
+    if (write_cell_weights || this->body_frame_projection) {
+        this->sync_line_force_model_state();
+        this->update_geometry_data();
+    }
+
+    if (write_cell_weights) {
+        this->write_cell_weights(coeffs_.getOrDefault<scalar>("cellWeightFactor", 10.0));
+    }
+}
+
+// Destructor
+Foam::fv::ActuatorLine::~ActuatorLine() {
+    if (this->registry) {
+        ActuatorLineRegistry::remove(mesh_, this);
+    }
+
+    // Also finishes any results that are queued for writing
+    stormbird_interface::delete_actuator_line(this->model);
 }
 
 void Foam::fv::ActuatorLine::sync_line_force_model_state() {
     int nr_wings = this->model->nr_wings();
 
-    std::vector<double> local_wing_angles;
-
-    for (int wing_index = 0; wing_index < nr_wings; wing_index++) {
-        local_wing_angles.push_back(0.0);
-    }
+    scalarField local_wing_angles(nr_wings, 0.0);
 
     if (Pstream::master()) {
         for (int wing_index = 0; wing_index < nr_wings; wing_index++) {
@@ -75,88 +187,369 @@ void Foam::fv::ActuatorLine::sync_line_force_model_state() {
         }
     }
 
-    // Sync the wing angles between processors
+    // Sync the wing angles between processors, with all wings in a single reduction
+    reduce(local_wing_angles, sumOp<scalarField>());
+
+    // Only update wings that have actually been rotated, as this also updates the geometry in the
+    // model. The projection data for these wings must be recomputed at the next update.
     for (int wing_index = 0; wing_index < nr_wings; wing_index++) {
-        reduce(local_wing_angles[wing_index], sumOp<double>());
+        if (local_wing_angles[wing_index] != this->model->get_local_wing_angle(wing_index)) {
+            this->model->set_local_wing_angle(wing_index, local_wing_angles[wing_index]);
+        }
+
+        if (local_wing_angles[wing_index] != this->wing_projection_data[wing_index].wing_angle) {
+            this->wing_projection_data[wing_index].outdated = true;
+        }
     }
+}
 
-    for (int wing_index = 0; wing_index < nr_wings; wing_index++) {
-        this->model->set_local_wing_angle(wing_index, local_wing_angles[wing_index]);
+void Foam::fv::ActuatorLine::update_geometry_data() {
+    // The cells move relative to the model when the mesh moves, unless the model is moved with 
+    // the mesh. The candidate boxes are given in the mesh coordinates at the time of the search, 
+    // and can not be reused in either case.
+    if (mesh_.moving() && mesh_.time().timeIndex() != this->mesh_motion_time_index) {
+        this->mesh_motion_time_index = mesh_.time().timeIndex();
+
+        if (this->body_frame_projection) {
+            if (this->body_frame_reference_is_set) {
+                this->update_body_frame_motion();
+            }
+        } else {
+            this->request_geometry_update();
+        }
+
+        for (WingProjectionData& wing_data : this->wing_projection_data) {
+            wing_data.candidate_box = treeBoundBox();
+        }
+    }
+
+    bool geometry_is_updated = false;
+
+    if (this->need_update && this->update_wing_projection_data()) {
+        this->set_candidate_cell_projection_weights();
+        this->set_relevant_cells();
+        this->set_projection_data();
+
+        if (this->model->use_point_sampling()) {
+            this->set_velocity_sampling_data_interpolation();
+        } else {
+            this->set_velocity_sampling_data_integral();
+        }
+
+        this->report_cell_data_memory();
+
+        geometry_is_updated = true;
+    } else if (
+        this->model->use_point_sampling() && mesh_.changing() && !this->body_frame_projection
+    ) {
+        // The control points must be located again when the mesh moves, even if the model 
+        // geometry is unchanged. In the body frame, the control points move with the cells.
+        this->set_velocity_sampling_data_interpolation();
+    }
+
+    // The reference must have the same relative geometry as the projection and sampling data
+    if (
+        this->body_frame_projection && 
+        (geometry_is_updated || !this->body_frame_reference_is_set)
+    ) {
+        this->set_body_frame_reference();
+    }
+}
+
+void Foam::fv::ActuatorLine::request_geometry_update() {
+    for (WingProjectionData& wing_data : this->wing_projection_data) {
+        wing_data.outdated = true;
+    }
+
+    this->need_update = true;
+}
+
+std::size_t Foam::fv::ActuatorLine::cell_data_memory() const {
+    std::size_t memory = 0;
+
+    for (const WingProjectionData& wing_data : this->wing_projection_data) {
+        memory += 
+            list_memory(wing_data.candidate_cells) +
+            vector_memory(wing_data.summed_weights) +
+            vector_memory(wing_data.max_weights) +
+            vector_memory(wing_data.dominating_line_indices) +
+            vector_memory(wing_data.line_weight_offsets) +
+            vector_memory(wing_data.line_weight_indices) +
+            vector_memory(wing_data.line_weights);
+    }
+
+    memory += 
+        list_memory(this->candidate_cells) +
+        vector_memory(this->candidate_cell_projection_weights) +
+        vector_memory(this->candidate_cell_dominating_line_indices) +
+        vector_memory(this->candidate_cell_entries) +
+        vector_memory(this->candidate_cell_max_weights) +
+        list_memory(this->relevant_cells) +
+        list_memory(this->relevant_cell_line_indices) +
+        list_memory(this->relevant_cell_weights) +
+        list_memory(this->projected_body_forces) +
+        list_memory(this->realigned_body_forces) +
+        list_memory(this->projection_matrix.row_offsets) +
+        list_memory(this->projection_matrix.line_indices) +
+        list_memory(this->projection_matrix.values) +
+        list_memory(this->projection_matrix.single_values) +
+        list_memory(this->velocity_sampling_weights) +
+        list_memory(this->velocity_sampling_weights_single) +
+        list_memory(this->body_frame_reference_points);
+
+    return memory;
+}
+
+/// Reports the memory used by the per-cell data on each processor, as minimum, maximum and 
+/// average values. Only reported when the memory has changed on at least one processor, which
+/// should only happen for the first few updates, as the lists reuse their capacity.
+void Foam::fv::ActuatorLine::report_cell_data_memory() {
+    std::size_t memory = this->cell_data_memory();
+
+    bool memory_changed = memory != this->reported_cell_data_memory;
+
+    reduce(memory_changed, orOp<bool>());
+
+    if (!memory_changed) {
+        return;
+    }
+
+    this->reported_cell_data_memory = memory;
+
+    scalar memory_mb = scalar(memory) / (1024.0 * 1024.0);
+
+    Info<< "Actuator line cell data memory per processor [MB] (min/max/avg): "
+        << returnReduce(memory_mb, minOp<scalar>()) << " / "
+        << returnReduce(memory_mb, maxOp<scalar>()) << " / "
+        << returnReduce(memory_mb, sumOp<scalar>()) / Pstream::nProcs() << endl;
+}
+
+void Foam::fv::ActuatorLine::sync_sectional_forces_to_project() {
+    label nr_values = 6 * this->model->nr_span_lines();
+
+    // All values are packed in one buffer, so that they can be shared in a single operation
+    scalarField forces(nr_values, 0.0);
+
+    if (Pstream::master()) {
+        this->model->get_sectional_lift_and_drag_forces_to_project(
+            rust::Slice<double>(forces.data(), nr_values)
+        );
+    }
+
+    reduce(forces, sumOp<scalarField>());
+
+    if (!Pstream::master()) {
+        this->model->set_sectional_lift_and_drag_forces_to_project(
+            rust::Slice<const double>(forces.data(), nr_values)
+        );
     }
 }
 
 void Foam::fv::ActuatorLine::add(const volVectorField& velocity_field, fvMatrix<vector>& eqn)
 {
-    const scalarField& cell_volumes = mesh_.V();
+    if (this->registry) {
+        // Prepares all instances on the mesh at the first call to the options, so that the 
+        // sampling data from all of them can be summed over the processors together
+        this->registry->prepare_calls(velocity_field, *this);
+    } else {
+        this->prepare_call(velocity_field);
+
+        if (this->call_samples_velocity) {
+            this->reduce_sampling_buffer(this->sampling_buffer);
+        }
+    }
+
+    this->finish_call(velocity_field, eqn);
+}
+
+/// Sums a sampling buffer over all processors
+void Foam::fv::ActuatorLine::reduce_sampling_buffer(scalarField& buffer) {
+    ActuatorLineTiming::ScopedTimer timer(this->timing, ActuatorLineTiming::sampling_communication);
+
+    reduce(buffer, sumOp<scalarField>());
+}
+
+/// Determines what to do in the current call, and does everything up to the communication of the
+/// sampled velocity. The velocity samples from this processor are stored in the sampling buffer.
+void Foam::fv::ActuatorLine::prepare_call(const volVectorField& velocity_field) {
     double time_step = mesh_.time().deltaTValue();
     double time = mesh_.time().value();
-    vectorField& equation_source = eqn.source();
+
+    // Check if this is the first call in a new time step
+    label time_index = mesh_.time().timeIndex();
+
+    bool new_time_step = time_index != this->last_time_index;
+    this->last_time_index = time_index;
+
+    // Determine what to do in this call. If the model is not solved, the forces from the last
+    // solve are projected again. The model is only advanced, written and given to the controller
+    // once per time step, except in the default coupling mode.
+    bool solve_model = true;
+    bool advance_model = true;
+
+    switch (this->coupling_mode) {
+        case CouplingMode::every_call:
+            break;
+        case CouplingMode::first_call:
+            solve_model = new_time_step;
+            advance_model = new_time_step;
+            break;
+        case CouplingMode::final_iteration:
+            solve_model = mesh_.data::template getOrDefault<bool>("finalIteration", false);
+            advance_model = solve_model;
+            break;
+        case CouplingMode::resample_every_call:
+            advance_model = new_time_step;
+            break;
+    }
+
+    this->call_is_prepared = true;
+    this->call_solves_model = solve_model;
+    this->call_advances_model = advance_model;
+    this->call_samples_velocity = false;
+
+    if (!solve_model) {
+        return;
+    }
 
     // Synchronize the line force model state across all processors
-    this->sync_line_force_model_state();
+    {
+        ActuatorLineTiming::ScopedTimer timer(this->timing, ActuatorLineTiming::sync_state);
+
+        this->sync_line_force_model_state();
+    }
 
     // Recalculate the projection and velocity sampling data if needed
-    if (this->need_update) {
-        this->set_projection_data();
+    {
+        ActuatorLineTiming::ScopedTimer timer(this->timing, ActuatorLineTiming::geometry_update);
+
+        this->update_geometry_data();
+    }
+
+    // The velocity is only needed at the time steps where the model is solved. When the model is
+    // only solved on the master, the other processors do not know the solver state.
+    bool sample_velocity = true;
+
+    if (this->solve_on_master_only) {
+        sample_velocity = Pstream::master() && this->model->is_solve_step(time, time_step);
+
+        reduce(sample_velocity, orOp<bool>());
+    } else {
+        sample_velocity = this->model->is_solve_step(time, time_step);
+    }
+
+    this->call_samples_velocity = sample_velocity;
+
+    if (sample_velocity) {
+        ActuatorLineTiming::ScopedTimer timer(this->timing, ActuatorLineTiming::velocity_sampling);
 
         if (this->model->use_point_sampling()) {
-            this->set_velocity_sampling_data_interpolation();
+            this->compute_interpolated_samples(velocity_field);
         } else {
-            this->set_velocity_sampling_data_integral();
-
+            this->compute_integrated_sampling_sums(velocity_field);
         }
     }
+}
 
-    const labelList& cell_ids = this->relevant_cells_for_projection;
+/// Does the rest of the current call, after the sampling buffer is summed over all processors
+void Foam::fv::ActuatorLine::finish_call(
+    const volVectorField& velocity_field, 
+    fvMatrix<vector>& eqn
+) {
+    double time_step = mesh_.time().deltaTValue();
+    double time = mesh_.time().value();
 
-    // Set the velocity field for the actuator line model
-    if (this->model->use_point_sampling()) {
-        this->set_interpolated_velocity(velocity_field);
-    } else {
-        this->set_integrated_weighted_velocity(velocity_field);
-    }
+    label time_index = mesh_.time().timeIndex();
 
-    // Calculate the circulation
-    this->model->do_step(time, time_step);
+    bool advance_model = this->call_advances_model;
+
+    this->call_is_prepared = false;
+
+    if (this->call_solves_model) {
+        this->solve_line_force_model(time, time_step, advance_model);
+    }
 
     // Apply the body force to the equation source
-    forAll(cell_ids, i) {
-        label cell_id = cell_ids[i];
+    {
+        ActuatorLineTiming::ScopedTimer timer(this->timing, ActuatorLineTiming::force_projection);
 
-        std::array<double, 3> cell_velocity = {
-            velocity_field[cell_id][0],
-            velocity_field[cell_id][1],
-            velocity_field[cell_id][2]
-        };
+        this->project_forces(velocity_field, eqn);
+    }
 
-        label line_index = this->dominating_line_element_index_projection[i];
+    // Check if the model needs to be updated at the next time step
+    if (advance_model) {
+        ActuatorLineTiming::ScopedTimer timer(this->timing, ActuatorLineTiming::output);
+
+        this->need_update = false;
+        if (Pstream::master()) {
+            this->need_update = model->update_controller(time, time_step);
+
+            if (this->write_results_asynchronously) {
+                this->model->write_results_asynchronously("postProcessing");
+            } else {
+                this->model->write_results("postProcessing");
+            }
+        }
+        reduce(this->need_update, orOp<bool>());
 
-        std::array<double, 3> force_to_project = this->model->force_to_project(
-            line_index,
-            cell_velocity
-        );
+        if (this->restart_data && mesh_.time().writeTime()) {
+            this->write_restart_data();
+        }
 
-        double body_force_weight = this->body_force_field_weight[0][cell_id];
+        if (this->body_force_fields == BodyForceFields::sparse && mesh_.time().writeTime()) {
+            this->write_sparse_body_force_fields();
+        }
+    }
 
-        vector body_force(vector::zero);
+    const bool report_timing = 
+        advance_model && 
+        this->timing_interval > 0 && 
+        time_index % this->timing_interval == 0 &&
+        time_index != this->timing_report_time_index;
 
-        body_force[0] = force_to_project[0] * body_force_weight * cell_volumes[cell_id];
-        body_force[1] = force_to_project[1] * body_force_weight * cell_volumes[cell_id];
-        body_force[2] = force_to_project[2] * body_force_weight * cell_volumes[cell_id];
+    if (report_timing) {
+        this->timing_report_time_index = time_index;
 
-        equation_source[cell_id] += body_force;
+        this->timing.report(
+            "postProcessing", 
+            time, 
+            this->nr_projection_cells, 
+            this->nr_sampling_cells
+        );
+    }
+}
 
-        this->body_force_field[0][cell_id] = body_force / cell_volumes[cell_id];
+void Foam::fv::ActuatorLine::solve_line_force_model(
+    const double time, 
+    const double time_step,
+    const bool advance_model
+) {
+    // Set the velocity in the model from the samples, which are summed over all processors
+    if (this->call_samples_velocity) {
+        if (this->model->use_point_sampling()) {
+            this->set_interpolated_velocity();
+        } else {
+            this->set_integrated_weighted_velocity();
+        }
     }
 
-    // Check if the model needs to be updated at the next time step
-    this->need_update = false;
-    if (Pstream::master()) {
-        this->need_update = model->update_controller(time, time_step);
+    // Calculate the circulation. Repeated solves for the same time step do not advance the 
+    // iteration counter in the model
+    if (!this->solve_on_master_only || Pstream::master()) {
+        ActuatorLineTiming::ScopedTimer timer(this->timing, ActuatorLineTiming::solve);
+
+        if (advance_model) {
+            this->model->do_step(time, time_step);
+        } else {
+            this->model->repeat_step(time, time_step);
+        }
+    }
+
+    if (this->solve_on_master_only) {
+        ActuatorLineTiming::ScopedTimer timer(this->timing, ActuatorLineTiming::force_sync);
 
-        this->model->write_results("postProcessing");
+        this->sync_sectional_forces_to_project();
     }
-    reduce(this->need_update, orOp<bool>());
 }
 
 void Foam::fv::ActuatorLine::addSup(
@@ -12,14 +12,60 @@
 #define ACTUATOR_LINE_H
 
 #include "cellSetOption.H"
+#include "Enum.H"
+#include "treeBoundBox.H"
+#include "cellPointWeight.H"
+#include "SHA1Digest.H"
+#include "DynamicList.H"
 #include "cpp_actuator_line.hpp"
+#include "parallel_loop.hpp"
+#include "timing.hpp"
+
+#include <array>
+#include <vector>
 
 namespace Foam {
     namespace fv {
+        class ActuatorLineRegistry;
+
         class ActuatorLine: public cellSetOption {
         public:
             TypeName("actuatorLine")
 
+            /// Determines how the model is coupled to the CFD solver when the source terms are 
+            /// requested several times per time step, for instance with several outer correctors
+            /// in PIMPLE.
+            enum class CouplingMode {
+                /// Sample, solve, write and update the controller at every call
+                every_call,
+                /// Only sample and solve at the first call in each time step. The other calls 
+                /// project the same forces.
+                first_call,
+                /// Only sample and solve at the final outer corrector, as marked by the solver. 
+                /// The other calls project the forces from the previous time step.
+                final_iteration,
+                /// Sample and solve at every call, but only write the results and update the 
+                /// controller at the first call in each time step.
+                resample_every_call
+            };
+
+            static const Enum<CouplingMode> coupling_mode_names;
+
+            /// Determines how the body force and the projection weight are stored for 
+            /// post-processing. The projection itself only uses the sparse data for the relevant 
+            /// cells, and does not depend on this choice.
+            enum class BodyForceFields {
+                /// Full mesh fields, written at every write time
+                dense,
+                /// Only the values in the relevant cells, written at every write time together
+                /// with a cell set containing the same cells
+                sparse,
+                /// No fields are stored or written
+                none
+            };
+
+            static const Enum<BodyForceFields> body_force_fields_names;
+
             /// Constructor
             ActuatorLine(
                 const word& name, 
@@ -29,7 +75,7 @@ namespace Foam {
             );
 
             /// Destructor
-            virtual ~ActuatorLine() = default;
+            virtual ~ActuatorLine();
 
             /// Necessary function in OpenFOAM to add volume forces in solvers which do not use the 
             /// density in the momentum equation
@@ -55,42 +101,277 @@ namespace Foam {
                 const label fieldi
             );
 
+            /// Marks the projection and sampling data for all wings as outdated, so that it is 
+            /// recomputed at the next call, in the same way as when the wings are rotated by a 
+            /// controller. Mainly intended for benchmarking of the geometry update.
+            void request_geometry_update();
+
         private:
             /// The Stormbird actuator line model
             stormbird_interface::CppActuatorLine* model;
             
-            /// The body force field, that will be exported by OpenFOAM during the simulation
-            volVectorField* body_force_field;
-            /// The body force field weight, that will be exported by OpenFOAM during the simulation
-            volScalarField* body_force_field_weight;
+            /// How the body force fields are stored. Read from the optional `bodyForceFields` 
+            /// entry in the fvOptions dictionary.
+            BodyForceFields body_force_fields = BodyForceFields::dense;
+
+            /// The body force field, that will be exported by OpenFOAM during the simulation. Only
+            /// allocated when the body force fields are dense.
+            volVectorField* body_force_field = nullptr;
+            /// The body force field weight, that will be exported by OpenFOAM during the 
+            /// simulation. Only allocated when the body force fields are dense.
+            volScalarField* body_force_field_weight = nullptr;
 
             // Switch to determine if the OpenFOAM data needs to be updated, due to changes in the 
             // actuator line model
             bool need_update = true;
+
+            /// Threads used in the loops over cells within each processor, started once when the
+            /// model is constructed. The number of threads is read from the optional `nThreads` 
+            /// entry in the fvOptions dictionary.
+            WorkerPool worker_pool;
+
+            /// Switch to write the results on a background thread, so that the time stepping does
+            /// not wait for the file system. Read from the optional `writeResultsAsynchronously` 
+            /// entry in the fvOptions dictionary.
+            bool write_results_asynchronously = false;
+
+            /// Switch to only solve the line force model on the master processor, and share the
+            /// resulting forces with the other processors. Read from the optional 
+            /// `solveOnMasterOnly` entry in the fvOptions dictionary.
+            bool solve_on_master_only = false;
+
+            /// How the model is coupled to the solver. Read from the optional `couplingMode` entry
+            /// in the fvOptions dictionary.
+            CouplingMode coupling_mode = CouplingMode::every_call;
+            /// The time index of the last call, used to detect new time steps
+            label last_time_index = -1;
+
+            /// Shared data for all instances on the same mesh that use the registry. Read from the
+            /// optional `sharedRegistry` entry in the fvOptions dictionary. Not owned by this 
+            /// instance.
+            ActuatorLineRegistry* registry = nullptr;
+
+            /// What to do in the current call, as determined when the call was prepared
+            bool call_is_prepared = false;
+            bool call_solves_model = false;
+            bool call_advances_model = false;
+            bool call_samples_velocity = false;
+            /// The velocity samples from this processor, or from all processors after the 
+            /// reduction. Contains the sums for the integral sampling, or the interpolated 
+            /// values at the control points.
+            scalarField sampling_buffer;
+
+            /// Timing of the different phases of the model
+            ActuatorLineTiming timing;
+            /// Number of time steps between each time the timing is reported. Read from the 
+            /// optional `timingInterval` entry in the fvOptions dictionary, where zero, the 
+            /// default, disables the reporting.
+            label timing_interval = 0;
+            /// The time index of the last timing report, so that the timing is reported at most
+            /// once per time step when the model is advanced at several calls
+            label timing_report_time_index = -1;
+
+            /// Switch to write the model state and the projection and sampling data at each write
+            /// time, and to read them again when the simulation is restarted. Read from the 
+            /// optional `restartData` entry in the fvOptions dictionary.
+            bool restart_data = false;
+
+            /// Switch to keep the projection and sampling data when the mesh moves as a rigid body,
+            /// and instead move the model with the same rigid transformation as the mesh. Read 
+            /// from the optional `bodyFrameProjection` entry in the fvOptions dictionary.
+            bool body_frame_projection = false;
+            /// The time index of the last mesh motion that was handled
+            label mesh_motion_time_index = -1;
+            /// The centres of the candidate cells when the body frame reference was set, and the 
+            /// global centroid and number of these points
+            vectorField body_frame_reference_points;
+            vector body_frame_reference_centroid = vector::zero;
+            label nr_body_frame_reference_points = 0;
+            bool body_frame_reference_is_set = false;
+
+            /// Switch to store the projection matrix and the velocity sampling weights in single
+            /// precision, and to evaluate the weights with the single precision kernels. This 
+            /// halves the memory, and the memory traffic at each time step, for the largest 
+            /// per-cell lists. The sums and the line force model are still computed in double 
+            /// precision. Read from the optional `singlePrecisionWeights` entry in the fvOptions 
+            /// dictionary.
+            bool single_precision_weights = false;
             
             // Store all relevant data
-            std::vector<label> interpolation_cells;
             std::vector<vector> ctrl_points;
+            /// The processor that samples the velocity at each control point, or -1 if the point
+            /// is not inside the mesh. Only one processor owns each point, also when the point is 
+            /// found on several processors.
+            labelList ctrl_point_owners;
+            /// The cell containing each control point on this processor at the last update, or -1
+            /// if the point was not found. Used as the starting point when searching for the 
+            /// point again after the geometry has changed.
+            labelList ctrl_point_cells;
+            /// Interpolation weights for the control points owned by this processor. Only depends
+            /// on the geometry, and is therefore computed at each update.
+            PtrList<cellPointWeight> ctrl_point_interpolation_weights;
 
-            labelList relevant_cells_for_projection;
-            labelList dominating_line_element_index_projection;
+            /// Projection data for the cells around a single wing. The data is stored separately 
+            /// for each wing, so that only wings that have been rotated need to be updated.
+            struct WingProjectionData {
+                /// The box used when searching for candidate cells, valid for all wing angles
+                treeBoundBox candidate_box;
+                /// Cells that are close enough to the wing to possibly be relevant
+                labelList candidate_cells;
+                /// Summed and maximum weight from the line elements on the wing, for each cell
+                std::vector<double> summed_weights;
+                std::vector<double> max_weights;
+                std::vector<std::size_t> dominating_line_indices;
+                /// The weight from each line element on the wing that is above the entry weight 
+                /// limit, for each candidate cell, in compressed row format with global line 
+                /// indices. Only used when the line elements are blended.
+                std::vector<std::size_t> line_weight_offsets;
+                std::vector<std::size_t> line_weight_indices;
+                std::vector<double> line_weights;
+                /// The local wing angle that the weights were computed with
+                double wing_angle = 0.0;
+                /// Switch to determine if the weights must be recomputed
+                bool outdated = true;
+            };
 
-            labelList relevant_cells_for_velocity_sampling;
-            labelList dominating_line_element_index_sampling;
+            std::vector<WingProjectionData> wing_projection_data;
+
+            // The per-cell data below is stored in lists that keep their capacity when the size is
+            // reduced, so that repeated geometry updates, for instance when the sails are trimmed 
+            // by a controller, reuse the same memory. All lists are sized by counting first, and 
+            // then filled, without appending one item at a time.
+
+            /// Cells that are close enough to at least one line element to possibly be relevant for
+            /// either the projection or the velocity sampling
+            DynamicList<label> candidate_cells;
+            /// Summed projection weight and dominating line element for each candidate cell,
+            /// computed once per geometry update and shared by the projection and sampling setup
+            std::vector<double> candidate_cell_projection_weights;
+            std::vector<std::size_t> candidate_cell_dominating_line_indices;
+
+            /// Work space when combining the candidate cells from all wings
+            std::vector<std::array<label, 3>> candidate_cell_entries;
+            std::vector<double> candidate_cell_max_weights;
+
+            /// Cells where the summed projection weight is above the weight limit for either the 
+            /// projection or the integral velocity sampling, sorted by cell label. The projection
+            /// and the sampling use the same set, which is the same for both with equal weight 
+            /// limits, so that the cell labels and the dominating line elements are only stored 
+            /// once, and the loops at each time step stream through the same lists in the order 
+            /// of the cells in the mesh. The per-cell data below is stored for each cell in this
+            /// set.
+            DynamicList<label> relevant_cells;
+            DynamicList<label> relevant_cell_line_indices;
+            /// The summed projection weight in each relevant cell
+            DynamicList<scalar> relevant_cell_weights;
+            /// Number of relevant cells above the weight limit for the projection and the 
+            /// integral velocity sampling
+            label nr_projection_cells = 0;
+            label nr_sampling_cells = 0;
+            /// The body force per volume in each relevant cell, from the last projection. Only 
+            /// stored when the body force fields are sparse.
+            DynamicList<vector> projected_body_forces;
+
+            /// Sparse matrix in compressed row format that maps the sectional forces on the line
+            /// elements to body forces in the cells. Each row corresponds to a relevant cell, 
+            /// where the rows are empty for cells below the projection weight limit, and each 
+            /// entry holds the projection weight from one line element multiplied with the cell 
+            /// volume. The values are stored in `single_values` instead of `values` when single 
+            /// precision weights are used.
+            struct ProjectionMatrix {
+                DynamicList<label> row_offsets;
+                DynamicList<label> line_indices;
+                DynamicList<scalar> values;
+                DynamicList<float> single_values;
+            };
+
+            ProjectionMatrix projection_matrix;
+
+            /// Geometric weight for each relevant cell in the integral velocity sampling, including
+            /// the cell volume, and zero for cells below the sampling weight limit. Only depends on
+            /// the geometry, and is therefore computed at each update.
+            DynamicList<scalar> velocity_sampling_weights;
+            /// Same as velocity_sampling_weights, used when single precision weights are used
+            DynamicList<float> velocity_sampling_weights_single;
+
+            /// Buffer for the sectional forces on all line elements in the projection, sized when the
+            /// projection data is set, so that it is not allocated at each time step
+            std::vector<double> sectional_forces_to_project;
+            /// Buffer for the body force in each relevant cell when the forces are realigned to
+            /// the local velocity, sized together with the relevant cells. Empty otherwise.
+            DynamicList<scalar> realigned_body_forces;
+
+            /// The memory allocated for the per-cell data on this processor at the last report
+            std::size_t reported_cell_data_memory = 0;
 
             /// The add function, intended to be use across all the OpenFOAM addSup functions
             void add(const volVectorField& velocity, fvMatrix<vector>& eqn);
 
             // Check which cells are relevant
+            bool update_wing_projection_data();
+            void set_wing_projection_data(const label wing_index);
+            void set_wing_line_weights(const label wing_index);
+            void set_candidate_cell_projection_weights();
+            void set_relevant_cells();
+            void count_relevant_cells();
             void set_projection_data();
+            void set_body_force_field_weights();
+            void set_projection_matrix();
+            void set_projection_buffers();
             void set_velocity_sampling_data_interpolation();
+            label find_cell_from_guess(
+                const vector& point, 
+                const label cell_guess,
+                const boundBox& local_bounds
+            ) const;
             void set_velocity_sampling_data_integral();
 
-            /// Ways to estimate the velocity
-            void set_integrated_weighted_velocity(const volVectorField& velocity);
-            void set_interpolated_velocity(const volVectorField& velocity);
+            /// Ways to estimate the velocity. The first function in each pair computes the samples
+            /// on this processor, and the second sets the velocity in the model after the samples
+            /// are summed over all processors.
+            void compute_integrated_sampling_sums(const volVectorField& velocity);
+            void set_integrated_weighted_velocity();
+            void compute_interpolated_samples(const volVectorField& velocity);
+            void set_interpolated_velocity();
+
+            /// Each call to the add function is split in two parts, separated by the reduction of
+            /// the sampling buffer, so that the reductions from several instances can be combined
+            void prepare_call(const volVectorField& velocity);
+            void reduce_sampling_buffer(scalarField& buffer);
+            void finish_call(const volVectorField& velocity, fvMatrix<vector>& eqn);
+
+            void solve_line_force_model(
+                const double time, 
+                const double time_step,
+                const bool advance_model
+            );
+
+            void update_geometry_data();
+
+            /// Rigid body motion of the mesh
+            void set_body_frame_reference();
+            void update_body_frame_motion();
+
+            /// Memory allocated for the per-cell data, in bytes
+            std::size_t cell_data_memory() const;
+            void report_cell_data_memory();
+
+            /// Restart data, written to the `uniform` folder of each time directory
+            void write_restart_data() const;
+            bool read_restart_data();
+            SHA1Digest mesh_digest() const;
+            void write_cell_weights(const scalar weight_factor) const;
 
             void sync_line_force_model_state();
+            void sync_sectional_forces_to_project();
+
+            /// Adds the body forces from the line elements to the equation source
+            void project_forces(const volVectorField& velocity_field, fvMatrix<vector>& eqn);
+            /// Stores the body force per volume in a relevant cell for post-processing
+            void store_body_force(const label row, const label cell_id, const vector& value);
+            void write_sparse_body_force_fields() const;
+
+            friend class ActuatorLineRegistry;
 
             // Copy constructor and assignment operator
             ActuatorLine(const ActuatorLine&) = delete;
@@ -0,0 +1,129 @@
+// Copyright (C) 2024, NTNU 
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+#include "actuator_line_registry.hpp"
+#include "actuator_line.hpp"
+
+namespace Foam {
+    namespace fv {
+        defineTypeNameAndDebug(ActuatorLineRegistry, 0);
+    }
+}
+
+Foam::fv::ActuatorLineRegistry& Foam::fv::ActuatorLineRegistry::New(const fvMesh& mesh) {
+    ActuatorLineRegistry* registry = 
+        mesh.thisDb().getObjectPtr<ActuatorLineRegistry>(typeName);
+
+    if (!registry) {
+        registry = new ActuatorLineRegistry(mesh);
+
+        regIOobject::store(registry);
+    }
+
+    return *registry;
+}
+
+void Foam::fv::ActuatorLineRegistry::remove(const fvMesh& mesh, ActuatorLine* instance) {
+    ActuatorLineRegistry* registry = 
+        mesh.thisDb().getObjectPtr<ActuatorLineRegistry>(typeName);
+
+    if (!registry) {
+        return;
+    }
+
+    DynamicList<ActuatorLine*>& instances = registry->instances;
+
+    label index = instances.find(instance);
+
+    if (index == -1) {
+        return;
+    }
+
+    for (label i = index; i < instances.size() - 1; i++) {
+        instances[i] = instances[i + 1];
+    }
+
+    instances.setSize(instances.size() - 1);
+}
+
+// Constructor
+Foam::fv::ActuatorLineRegistry::ActuatorLineRegistry(const fvMesh& mesh): 
+    regIOobject(
+        IOobject(
+            typeName,
+            mesh.time().constant(),
+            mesh.thisDb(),
+            IOobject::NO_READ,
+            IOobject::NO_WRITE,
+            true
+        )
+    )
+{}
+
+void Foam::fv::ActuatorLineRegistry::add_instance(ActuatorLine* instance) {
+    this->instances.append(instance);
+}
+
+void Foam::fv::ActuatorLineRegistry::prepare_calls(
+    const volVectorField& velocity, 
+    ActuatorLine& caller
+) {
+    if (caller.call_is_prepared) {
+        return;
+    }
+
+    this->sampling_instances.clear();
+
+    label buffer_size = 0;
+
+    for (ActuatorLine* instance : this->instances) {
+        if (instance->call_is_prepared) {
+            continue;
+        }
+
+        instance->prepare_call(velocity);
+
+        // The choice to sample is the same on all processors, so the combined buffer has the 
+        // same layout everywhere
+        if (instance->call_samples_velocity) {
+            this->sampling_instances.append(instance);
+
+            buffer_size += instance->sampling_buffer.size();
+        }
+    }
+
+    if (buffer_size == 0) {
+        return;
+    }
+
+    scalarField& buffer = this->combined_sampling_buffer;
+
+    buffer.setSize(buffer_size);
+
+    label offset = 0;
+
+    for (const ActuatorLine* instance : this->sampling_instances) {
+        forAll(instance->sampling_buffer, i) {
+            buffer[offset + i] = instance->sampling_buffer[i];
+        }
+
+        offset += instance->sampling_buffer.size();
+    }
+
+    caller.reduce_sampling_buffer(buffer);
+
+    offset = 0;
+
+    for (ActuatorLine* instance : this->sampling_instances) {
+        forAll(instance->sampling_buffer, i) {
+            instance->sampling_buffer[i] = buffer[offset + i];
+        }
+
+        offset += instance->sampling_buffer.size();
+    }
+}
+
+Foam::bitSet& Foam::fv::ActuatorLineRegistry::candidate_cell_work_set() {
+    return this->candidate_cells;
+}
@@ -0,0 +1,72 @@
+// Copyright (C) 2024, NTNU 
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+///
+/// Registry for several actuator line instances on the same mesh, for instance when each sail in a
+/// fleet of ships is given as a separate entry in the fvOptions dictionary. The registry is stored
+/// in the object registry of the mesh, and is shared by all instances that use it.
+///
+
+#ifndef ACTUATOR_LINE_REGISTRY_H
+#define ACTUATOR_LINE_REGISTRY_H
+
+#include "fvMesh.H"
+#include "volFields.H"
+#include "regIOobject.H"
+#include "DynamicList.H"
+#include "bitSet.H"
+
+namespace Foam {
+    namespace fv {
+        class ActuatorLine;
+
+        class ActuatorLineRegistry: public regIOobject {
+        public:
+            TypeName("actuatorLineRegistry")
+
+            /// Returns the registry on the input mesh, which is created at the first call
+            static ActuatorLineRegistry& New(const fvMesh& mesh);
+
+            /// Removes the instance from the registry on the input mesh, if the registry still
+            /// exists
+            static void remove(const fvMesh& mesh, ActuatorLine* instance);
+
+            /// Constructor
+            explicit ActuatorLineRegistry(const fvMesh& mesh);
+
+            void add_instance(ActuatorLine* instance);
+
+            /// Prepares the current call for all instances that are not already prepared, and
+            /// sums the sampling buffers from all of them over the processors in a single 
+            /// reduction. Does nothing if the calling instance is already prepared, as the other
+            /// instances are then prepared in the same call to the options.
+            void prepare_calls(const volVectorField& velocity, ActuatorLine& caller);
+
+            /// Work space for the search for candidate cells, with one bit for each cell. Shared,
+            /// so that the memory is only allocated once for all instances.
+            bitSet& candidate_cell_work_set();
+
+            /// Nothing is written
+            virtual bool writeData(Ostream&) const {
+                return true;
+            }
+
+        private:
+            /// The registered instances, in the order they are constructed, which is the same on 
+            /// all processors
+            DynamicList<ActuatorLine*> instances;
+
+            /// The instances that are prepared in the current call to the options, and have 
+            /// sampled the velocity
+            DynamicList<ActuatorLine*> sampling_instances;
+
+            /// The sampling buffers from all instances, combined for the reduction
+            scalarField combined_sampling_buffer;
+
+            bitSet candidate_cells;
+        };
+    }
+}
+
+#endif
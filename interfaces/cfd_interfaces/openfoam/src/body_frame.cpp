@@ -0,0 +1,124 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+#include "fvMesh.H"
+#include "volFields.H"
+#include "tensor.H"
+#include "SVD.H"
+
+#include <array>
+
+#include "actuator_line.hpp"
+
+#include "cpp_actuator_line.hpp"
+
+/// Stores the current centres of the candidate cells as the reference for the mesh motion,
+/// together with the current position of the model. Called after each geometry update, so that
+/// the reference has the same relative geometry as the projection and sampling data.
+void Foam::fv::ActuatorLine::set_body_frame_reference() {
+    const vectorField& cell_centers = mesh_.C().primitiveField();
+
+    this->body_frame_reference_points = vectorField(cell_centers, this->candidate_cells);
+
+    vector point_sum = sum(this->body_frame_reference_points);
+    label nr_points = this->body_frame_reference_points.size();
+
+    reduce(point_sum, sumOp<vector>());
+    reduce(nr_points, sumOp<label>());
+
+    this->body_frame_reference_centroid = point_sum / Foam::max(nr_points, label(1));
+    this->nr_body_frame_reference_points = nr_points;
+    this->body_frame_reference_is_set = true;
+
+    this->model->set_body_frame_reference();
+}
+
+/// Estimates the rigid transformation of the mesh since the reference was set, from the current
+/// and the reference centres of the candidate cells, and moves the model with the same
+/// transformation. The rotation is the one that best fits the points in a least squares sense,
+/// computed from the singular value decomposition of the covariance matrix between the two sets
+/// of points, also known as the Kabsch algorithm. This is exact as long as the cells move as a
+/// rigid body, and all processors get the same transformation.
+void Foam::fv::ActuatorLine::update_body_frame_motion() {
+    // At least three points that are not on a line are needed to define a rotation
+    if (this->nr_body_frame_reference_points < 3) {
+        return;
+    }
+
+    const vectorField& cell_centers = mesh_.C().primitiveField();
+    const labelList& cell_ids = this->candidate_cells;
+
+    const vector& reference_centroid = this->body_frame_reference_centroid;
+
+    // The sum of the current points and the covariance matrix are packed in one field, so that
+    // they can be summed over all processors in a single reduction. Both sets of points are
+    // given relative to the reference centroid, which means that the sum of the reference points
+    // is zero.
+    scalarField sums(12, 0.0);
+
+    forAll(cell_ids, i) {
+        vector reference_point = this->body_frame_reference_points[i] - reference_centroid;
+        vector current_point = cell_centers[cell_ids[i]] - reference_centroid;
+
+        for (direction a = 0; a < vector::nComponents; a++) {
+            sums[a] += current_point[a];
+
+            for (direction b = 0; b < vector::nComponents; b++) {
+                sums[3 + 3 * a + b] += reference_point[a] * current_point[b];
+            }
+        }
+    }
+
+    reduce(sums, sumOp<scalarField>());
+
+    vector centroid_displacement(sums[0], sums[1], sums[2]);
+    centroid_displacement /= scalar(this->nr_body_frame_reference_points);
+
+    scalarRectangularMatrix covariance(3, 3);
+
+    for (label a = 0; a < 3; a++) {
+        for (label b = 0; b < 3; b++) {
+            covariance(a, b) = sums[3 + 3 * a + b];
+        }
+    }
+
+    SVD svd(covariance);
+
+    const scalarRectangularMatrix& u = svd.U();
+    const scalarRectangularMatrix& v = svd.V();
+
+    tensor u_tensor(
+        u(0, 0), u(0, 1), u(0, 2),
+        u(1, 0), u(1, 1), u(1, 2),
+        u(2, 0), u(2, 1), u(2, 2)
+    );
+
+    tensor v_tensor(
+        v(0, 0), v(0, 1), v(0, 2),
+        v(1, 0), v(1, 1), v(1, 2),
+        v(2, 0), v(2, 1), v(2, 2)
+    );
+
+    // Avoids a reflection instead of a rotation
+    scalar reflection_sign = det(v_tensor & u_tensor.T()) < 0.0 ? -1.0 : 1.0;
+
+    tensor reflection(1, 0, 0, 0, 1, 0, 0, 0, reflection_sign);
+
+    tensor rotation = v_tensor & reflection & u_tensor.T();
+
+    vector translation =
+        reference_centroid + centroid_displacement - (rotation & reference_centroid);
+
+    std::array<double, 9> rotation_matrix;
+
+    for (direction i = 0; i < tensor::nComponents; i++) {
+        rotation_matrix[i] = rotation[i];
+    }
+
+    this->model->move_with_body_frame(
+        rotation_matrix,
+        {translation[0], translation[1], translation[2]},
+        mesh_.time().deltaTValue()
+    );
+}
@@ -0,0 +1,78 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+///
+/// Helpers for passing OpenFOAM fields and lists to the Rust interface as slices, without copying
+/// the data. The Rust side expects vectors as three consecutive doubles, scalars as doubles, and
+/// labels as 32 bit integers. This is checked at compile time, so that a build with a different
+/// precision or label size fails here instead of giving wrong results.
+///
+
+#ifndef FIELD_VIEWS_H
+#define FIELD_VIEWS_H
+
+#include "label.H"
+#include "scalar.H"
+#include "vector.H"
+#include "UList.H"
+#include "SubList.H"
+
+#include <cstdint>
+#include <type_traits>
+
+#include "cpp_actuator_line.hpp"
+
+static_assert(
+    std::is_same<Foam::scalar, double>::value,
+    "The actuator line interface requires a double precision build of OpenFOAM (WM_PRECISION_OPTION=DP)"
+);
+static_assert(
+    sizeof(Foam::vector) == 3 * sizeof(double) && alignof(Foam::vector) == alignof(double),
+    "Foam::vector must be three contiguous doubles to be passed to the actuator line interface"
+);
+static_assert(
+    std::is_same<Foam::label, std::int32_t>::value,
+    "The actuator line interface requires 32 bit labels in OpenFOAM (WM_LABEL_SIZE=32)"
+);
+
+namespace Foam {
+    namespace fv {
+        /// View of a vector field as three consecutive values per item
+        inline rust::Slice<const double> as_slice(const UList<vector>& field) {
+            return rust::Slice<const double>(
+                reinterpret_cast<const double*>(field.cdata()), 3 * std::size_t(field.size())
+            );
+        }
+
+        inline rust::Slice<const double> as_slice(const UList<scalar>& field) {
+            return rust::Slice<const double>(field.cdata(), field.size());
+        }
+
+        inline rust::Slice<double> as_mut_slice(UList<scalar>& field) {
+            return rust::Slice<double>(field.data(), field.size());
+        }
+
+        /// View of a list of single precision values, used for weights stored in single 
+        /// precision
+        inline rust::Slice<const float> as_slice(const UList<float>& list) {
+            return rust::Slice<const float>(list.cdata(), list.size());
+        }
+
+        inline rust::Slice<float> as_mut_slice(UList<float>& list) {
+            return rust::Slice<float>(list.data(), list.size());
+        }
+
+        inline rust::Slice<const std::int32_t> as_slice(const UList<label>& list) {
+            return rust::Slice<const std::int32_t>(list.cdata(), list.size());
+        }
+
+        /// View of the items in the range [start, end) of a list
+        template<class Type>
+        inline auto as_slice(const UList<Type>& list, const label start, const label end) {
+            return as_slice(SubList<Type>(list, end - start, start));
+        }
+    }
+}
+
+#endif
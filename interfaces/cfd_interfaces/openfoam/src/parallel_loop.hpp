@@ -0,0 +1,213 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+///
+/// Simple helpers for running loops over cells on several threads within a single MPI process.
+/// This is intended for hybrid simulations, where there are fewer MPI processes than cores.
+///
+
+#ifndef PARALLEL_LOOP_H
+#define PARALLEL_LOOP_H
+
+#include "label.H"
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Foam {
+    namespace fv {
+        /// The number of chunks used when looping over the input number of items with the input
+        /// number of threads. Small loops are not split, as the thread overhead would dominate.
+        inline label nr_loop_chunks(const label nr_threads, const label nr_items) {
+            const label min_chunk_size = 1024;
+
+            label nr_chunks = nr_items / min_chunk_size;
+
+            if (nr_chunks > nr_threads) {
+                nr_chunks = nr_threads;
+            }
+
+            if (nr_chunks < 1) {
+                nr_chunks = 1;
+            }
+
+            return nr_chunks;
+        }
+
+        /// Threads that are started once, and then reused for all parallel loops, so that the 
+        /// loops at each time step do not pay for starting and joining threads. The calling thread
+        /// takes part in each loop, so a pool with one thread has no workers.
+        class WorkerPool {
+        public:
+            explicit WorkerPool(const label nr_threads = 1) {
+                this->start(nr_threads);
+            }
+
+            ~WorkerPool() {
+                this->stop();
+            }
+
+            WorkerPool(const WorkerPool&) = delete;
+            WorkerPool& operator=(const WorkerPool&) = delete;
+
+            /// Replaces the workers with a new set, so that the pool uses the input number of
+            /// threads in total
+            void resize(const label nr_threads) {
+                this->stop();
+                this->start(nr_threads);
+            }
+
+            label nr_threads() const {
+                return label(this->workers.size()) + 1;
+            }
+
+            /// Calls `task(chunk_index)` for each chunk index in [0, nr_chunks), where the calling
+            /// thread handles chunk 0 and worker i handles chunk i + 1. Returns when all chunks 
+            /// are done. The number of chunks can not be larger than the number of threads.
+            void run(const label nr_chunks, const std::function<void(label)>& task) {
+                if (nr_chunks <= 1) {
+                    task(label(0));
+
+                    return;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+
+                    this->current_task = &task;
+                    this->current_nr_chunks = nr_chunks;
+                    this->nr_remaining_chunks = nr_chunks - 1;
+                    this->generation++;
+                }
+
+                this->start_condition.notify_all();
+
+                task(label(0));
+
+                std::unique_lock<std::mutex> lock(this->mutex);
+
+                this->done_condition.wait(lock, [this] { return this->nr_remaining_chunks == 0; });
+
+                this->current_task = nullptr;
+            }
+
+        private:
+            std::vector<std::thread> workers;
+
+            std::mutex mutex;
+            std::condition_variable start_condition;
+            std::condition_variable done_condition;
+
+            /// The current loop, which is identified by the generation number
+            const std::function<void(label)>* current_task = nullptr;
+            label current_nr_chunks = 0;
+            label nr_remaining_chunks = 0;
+            std::size_t generation = 0;
+            bool stopping = false;
+
+            void start(const label nr_threads) {
+                this->stopping = false;
+
+                const std::size_t start_generation = this->generation;
+
+                for (label worker_index = 0; worker_index < nr_threads - 1; worker_index++) {
+                    this->workers.emplace_back([this, worker_index, start_generation] {
+                        this->work(worker_index, start_generation);
+                    });
+                }
+            }
+
+            void stop() {
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+
+                    this->stopping = true;
+                }
+
+                this->start_condition.notify_all();
+
+                for (std::thread& worker : this->workers) {
+                    worker.join();
+                }
+
+                this->workers.clear();
+            }
+
+            void work(const label worker_index, const std::size_t start_generation) {
+                const label chunk_index = worker_index + 1;
+
+                std::size_t finished_generation = start_generation;
+
+                while (true) {
+                    const std::function<void(label)>* task = nullptr;
+
+                    {
+                        std::unique_lock<std::mutex> lock(this->mutex);
+
+                        this->start_condition.wait(lock, [&] {
+                            return this->stopping || this->generation != finished_generation;
+                        });
+
+                        if (this->stopping) {
+                            return;
+                        }
+
+                        finished_generation = this->generation;
+
+                        // Loops with fewer chunks than threads leave some workers idle
+                        if (chunk_index < this->current_nr_chunks) {
+                            task = this->current_task;
+                        }
+                    }
+
+                    if (task) {
+                        (*task)(chunk_index);
+
+                        std::lock_guard<std::mutex> lock(this->mutex);
+
+                        this->nr_remaining_chunks--;
+
+                        if (this->nr_remaining_chunks == 0) {
+                            this->done_condition.notify_one();
+                        }
+                    }
+                }
+            }
+        };
+
+        /// Splits the index range [0, nr_items) into contiguous chunks, and calls
+        /// `func(start, end, chunk_index)` for each chunk on a separate thread from the pool. The 
+        /// calling thread handles the first chunk. The number of chunks is given by 
+        /// [nr_loop_chunks], so that per-chunk data can be allocated before the call. Loops that
+        /// are too small to be split run directly on the calling thread.
+        ///
+        /// The function must only write to data that is unique for the chunk. Note that OpenFOAM
+        /// computes some mesh data, such as cell centres and volumes, on first access. Such data
+        /// must therefore be accessed before the loop.
+        template<class Function>
+        void parallel_for(WorkerPool& pool, const label nr_items, Function func) {
+            const label nr_chunks = nr_loop_chunks(pool.nr_threads(), nr_items);
+
+            if (nr_chunks == 1) {
+                func(label(0), nr_items, label(0));
+
+                return;
+            }
+
+            auto chunk_start = [nr_items, nr_chunks](const label chunk_index) {
+                return (nr_items * chunk_index) / nr_chunks;
+            };
+
+            pool.run(nr_chunks, [&](const label chunk_index) {
+                func(chunk_start(chunk_index), chunk_start(chunk_index + 1), chunk_index);
+            });
+        }
+    }
+}
+
+#endif
@@ -10,41 +10,736 @@
 #include "interpolationCellPoint.H"
 
 #include "OFstream.H"
+#include "DynamicList.H"
+#include "bitSet.H"
+#include "treeBoundBox.H"
+#include "treeDataCell.H"
+#include "indexedOctree.H"
+#include "cellSet.H"
+#include "IOField.H"
+#include "labelIOList.H"
+
+#include <algorithm>
+#include <array>
 
 #include "actuator_line.hpp"
+#include "actuator_line_registry.hpp"
+#include "field_views.hpp"
 
 #include "cpp_actuator_line.hpp"
 
-void Foam::fv::ActuatorLine::set_projection_data() {
-    const vectorField& cell_centers = mesh_.C();
-    
-    const labelList& cell_ids = cells();
+bool Foam::fv::ActuatorLine::update_wing_projection_data() {
+    bool any_update = false;
+
+    for (label wing_index = 0; wing_index < label(this->wing_projection_data.size()); wing_index++) {
+        if (this->wing_projection_data[wing_index].outdated) {
+            this->set_wing_projection_data(wing_index);
+
+            any_update = true;
+        }
+    }
+
+    return any_update;
+}
+
+void Foam::fv::ActuatorLine::set_wing_projection_data(const label wing_index) {
+    WingProjectionData& wing_data = this->wing_projection_data[wing_index];
+
+    // The boxes must contain all cells that are relevant for either the projection or the sampling
+    double weight_limit = Foam::min(
+        this->model->projection_weight_limit(),
+        this->model->sampling_weight_limit()
+    );
+
+    std::array<std::size_t, 2> line_indices = this->model->wing_line_indices(wing_index);
+
+    DynamicList<treeBoundBox> line_boxes;
+    treeBoundBox wing_box;
+
+    for (std::size_t line_index = line_indices[0]; line_index < line_indices[1]; line_index++) {
+        std::array<double, 6> bounds = this->model->line_element_swept_bounding_box(
+            line_index, 
+            weight_limit
+        );
+
+        // Empty box, meaning that the line element can not contribute above the weight limit
+        if (bounds[0] > bounds[3]) {
+            continue;
+        }
+
+        treeBoundBox line_box(
+            point(bounds[0], bounds[1], bounds[2]),
+            point(bounds[3], bounds[4], bounds[5])
+        );
+
+        line_boxes.append(line_box);
+        wing_box.add(line_box);
+    }
+
+    // The swept boxes do not depend on the wing angle, so the candidate cells from the previous 
+    // search can be reused as long as the wing has not moved outside the previous box
+    bool wing_box_is_covered = true;
+
+    for (direction d = 0; d < vector::nComponents; d++) {
+        if (
+            wing_box.min()[d] < wing_data.candidate_box.min()[d] || 
+            wing_box.max()[d] > wing_data.candidate_box.max()[d]
+        ) {
+            wing_box_is_covered = false;
+        }
+    }
+
+    if (!wing_box_is_covered) {
+        const indexedOctree<treeDataCell>& cell_tree = mesh_.cellTree();
+
+        const boundBox& mesh_bounds = mesh_.bounds();
+
+        // The same work space is used for all instances that share a registry
+        bitSet local_candidates;
+
+        bitSet& is_candidate = 
+            this->registry ? this->registry->candidate_cell_work_set() : local_candidates;
+
+        is_candidate.reset();
+        is_candidate.resize(mesh_.nCells());
+
+        forAll(line_boxes, i) {
+            if (line_boxes[i].overlaps(mesh_bounds)) {
+                // The cell tree covers all cells in the mesh, so the shape indices are cell labels
+                is_candidate.set(cell_tree.findBox(line_boxes[i]));
+            }
+        }
+
+        if (selectionMode_ != smAll) {
+            is_candidate &= bitSet(mesh_.nCells(), cells());
+        }
+
+        wing_data.candidate_cells = is_candidate.toc();
+        wing_data.candidate_box = wing_box;
+    }
+
+    // Recompute the weights for the candidate cells of this wing
+    const vectorField& cell_centers = mesh_.C().primitiveField();
+
+    const labelList& cell_ids = wing_data.candidate_cells;
+
+    std::size_t nr_cells = cell_ids.size();
+
+    wing_data.summed_weights.resize(nr_cells);
+    wing_data.max_weights.resize(nr_cells);
+    wing_data.dominating_line_indices.resize(nr_cells);
+
+    // One call across the interface for each chunk of candidate cells of the wing
+    parallel_for(this->worker_pool, nr_cells, [&](label start, label end, label) {
+        std::size_t chunk_size = end - start;
+
+        this->model->wing_projection_data_at_cells(
+            wing_index,
+            as_slice(cell_centers),
+            as_slice(cell_ids, start, end),
+            rust::Slice<double>(wing_data.summed_weights.data() + start, chunk_size),
+            rust::Slice<double>(wing_data.max_weights.data() + start, chunk_size),
+            rust::Slice<std::size_t>(wing_data.dominating_line_indices.data() + start, chunk_size)
+        );
+    });
+
+    if (this->model->blend_line_elements()) {
+        this->set_wing_line_weights(wing_index);
+    }
+
+    wing_data.wing_angle = this->model->get_local_wing_angle(wing_index);
+    wing_data.outdated = false;
+}
+
+/// Stores the weight from each line element on the wing in each candidate cell of the wing, which
+/// is used to build the projection matrix when the line elements are blended. Only the line 
+/// elements on the wing are evaluated, and line elements that can not contribute to a block of 
+/// cells are skipped, as for the other projection data.
+void Foam::fv::ActuatorLine::set_wing_line_weights(const label wing_index) {
+    WingProjectionData& wing_data = this->wing_projection_data[wing_index];
+
+    const vectorField& cell_centers = mesh_.C().primitiveField();
+
+    const labelList& cell_ids = wing_data.candidate_cells;
+
+    label nr_cells = cell_ids.size();
+
+    // The summed weight in a cell above the weight limit exceeds the limit, so at least one
+    // line element will contribute more than this limit, and no projection row will be empty
+    double entry_weight_limit = 
+        this->model->projection_weight_limit() / this->model->nr_span_lines();
+
+    label nr_chunks = nr_loop_chunks(this->worker_pool.nr_threads(), nr_cells);
+
+    // The weights for each chunk of cells, where the point indices are relative to the first 
+    // cell in the chunk
+    std::vector<rust::Vec<stormbird_interface::LineElementWeight>> chunk_weights(nr_chunks);
+    labelList chunk_starts(nr_chunks, 0);
+
+    parallel_for(this->worker_pool, nr_cells, [&](label start, label end, label chunk) {
+        chunk_starts[chunk] = start;
+
+        if (this->single_precision_weights) {
+            chunk_weights[chunk] = this->model->wing_line_element_weights_at_cells_single(
+                wing_index,
+                as_slice(cell_centers),
+                as_slice(cell_ids, start, end),
+                entry_weight_limit
+            );
+        } else {
+            chunk_weights[chunk] = this->model->wing_line_element_weights_at_cells(
+                wing_index,
+                as_slice(cell_centers),
+                as_slice(cell_ids, start, end),
+                entry_weight_limit
+            );
+        }
+    });
 
-    this->relevant_cells_for_projection = labelList();
+    std::size_t nr_entries = 0;
+
+    for (label chunk = 0; chunk < nr_chunks; chunk++) {
+        nr_entries += chunk_weights[chunk].size();
+    }
+
+    wing_data.line_weight_offsets.assign(nr_cells + 1, 0);
+    wing_data.line_weight_indices.resize(nr_entries);
+    wing_data.line_weights.resize(nr_entries);
+
+    // The weights are sorted by point index, and the chunks are in cell order, so the entries 
+    // can be filled directly
+    std::size_t k = 0;
+
+    for (label chunk = 0; chunk < nr_chunks; chunk++) {
+        for (const stormbird_interface::LineElementWeight& weight : chunk_weights[chunk]) {
+            wing_data.line_weight_offsets[chunk_starts[chunk] + weight.point_index + 1]++;
+            wing_data.line_weight_indices[k] = weight.line_index;
+            wing_data.line_weights[k] = weight.weight;
+
+            k++;
+        }
+    }
+
+    for (label i = 0; i < nr_cells; i++) {
+        wing_data.line_weight_offsets[i + 1] += wing_data.line_weight_offsets[i];
+    }
+}
+
+void Foam::fv::ActuatorLine::set_candidate_cell_projection_weights() {
+    // Collect the candidate cells from all wings, together with the wing index and the index in 
+    // the wing data, sorted by cell label so that cells shared between wings end up next to 
+    // each other
+    std::vector<std::array<label, 3>>& entries = this->candidate_cell_entries;
+
+    std::size_t nr_entries = 0;
+
+    for (const WingProjectionData& wing_data : this->wing_projection_data) {
+        nr_entries += wing_data.candidate_cells.size();
+    }
+
+    entries.resize(nr_entries);
+
+    std::size_t entry_index = 0;
+
+    for (label wing_index = 0; wing_index < label(this->wing_projection_data.size()); wing_index++) {
+        const labelList& wing_cells = this->wing_projection_data[wing_index].candidate_cells;
+
+        forAll(wing_cells, i) {
+            entries[entry_index++] = {wing_cells[i], wing_index, i};
+        }
+    }
+
+    std::sort(entries.begin(), entries.end());
+
+    label nr_cells = 0;
+
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        if (i == 0 || entries[i][0] != entries[i - 1][0]) {
+            nr_cells++;
+        }
+    }
+
+    this->candidate_cells.setSize(nr_cells);
+    this->candidate_cell_projection_weights.assign(nr_cells, 0.0);
+    this->candidate_cell_dominating_line_indices.assign(nr_cells, 0);
+
+    // Combine the data from each wing. The summed weights are added, and the dominating line 
+    // element is taken from the wing with the largest single weight in the cell.
+    std::vector<double>& max_weights = this->candidate_cell_max_weights;
+
+    max_weights.assign(nr_cells, -1.0);
+
+    label cell_index = -1;
+
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        if (i == 0 || entries[i][0] != entries[i - 1][0]) {
+            cell_index++;
+
+            this->candidate_cells[cell_index] = entries[i][0];
+        }
+
+        const WingProjectionData& wing_data = this->wing_projection_data[entries[i][1]];
+
+        label wing_cell_index = entries[i][2];
+
+        this->candidate_cell_projection_weights[cell_index] += 
+            wing_data.summed_weights[wing_cell_index];
+
+        if (wing_data.max_weights[wing_cell_index] > max_weights[cell_index]) {
+            max_weights[cell_index] = wing_data.max_weights[wing_cell_index];
+
+            this->candidate_cell_dominating_line_indices[cell_index] = 
+                wing_data.dominating_line_indices[wing_cell_index];
+        }
+    }
+}
+
+/// Selects the relevant cells from the candidate cells, as the cells where the summed projection 
+/// weight is above the weight limit for either the projection or the integral velocity sampling.
+/// The candidate cells are sorted by cell label, and so are the relevant cells.
+void Foam::fv::ActuatorLine::set_relevant_cells() {
+    const labelList& cell_ids = this->candidate_cells;
 
     double weight_limit = this->model->projection_weight_limit();
 
-    forAll(cell_ids, i) {
-        label cell_id = cell_ids[i];
+    if (!this->model->use_point_sampling()) {
+        weight_limit = Foam::min(weight_limit, this->model->sampling_weight_limit());
+    }
+
+    // The dense fields are only set in the relevant cells, so the values from the previous update
+    // must be removed explicitly
+    if (this->body_force_fields == BodyForceFields::dense) {
+        forAll(this->relevant_cells, i) {
+            label cell_id = this->relevant_cells[i];
+
+            this->body_force_field[0][cell_id] = vector::zero;
+            this->body_force_field_weight[0][cell_id] = 0.0;
+        }
+    }
+
+    // Count the relevant cells in each chunk first, so that each chunk knows where to write
+    // its cells afterwards
+    label nr_chunks = nr_loop_chunks(this->worker_pool.nr_threads(), cell_ids.size());
+
+    labelList chunk_offsets(nr_chunks + 1, 0);
+
+    parallel_for(this->worker_pool, cell_ids.size(), [&](label start, label end, label chunk) {
+        for (label i = start; i < end; i++) {
+            if (this->candidate_cell_projection_weights[i] > weight_limit) {
+                chunk_offsets[chunk + 1]++;
+            }
+        }
+    });
+
+    for (label chunk = 0; chunk < nr_chunks; chunk++) {
+        chunk_offsets[chunk + 1] += chunk_offsets[chunk];
+    }
+
+    label nr_relevant_cells = chunk_offsets[nr_chunks];
+
+    this->relevant_cells.setSize(nr_relevant_cells);
+    this->relevant_cell_line_indices.setSize(nr_relevant_cells);
+    this->relevant_cell_weights.setSize(nr_relevant_cells);
 
-        std::array<double, 3> cell_center = {
-            cell_centers[cell_id][0],
-            cell_centers[cell_id][1],
-            cell_centers[cell_id][2]
+    parallel_for(this->worker_pool, cell_ids.size(), [&](label start, label end, label chunk) {
+        label relevant_index = chunk_offsets[chunk];
+
+        for (label i = start; i < end; i++) {
+            double summed_weight = this->candidate_cell_projection_weights[i];
+
+            if (summed_weight > weight_limit) {
+                this->relevant_cells[relevant_index] = cell_ids[i];
+                this->relevant_cell_line_indices[relevant_index] = 
+                    this->candidate_cell_dominating_line_indices[i];
+                this->relevant_cell_weights[relevant_index] = summed_weight;
+
+                relevant_index++;
+            }
+        }
+    });
+
+    this->count_relevant_cells();
+}
+
+/// Counts the relevant cells that are above the weight limit for the projection and for the 
+/// integral velocity sampling
+void Foam::fv::ActuatorLine::count_relevant_cells() {
+    const double projection_weight_limit = this->model->projection_weight_limit();
+    const double sampling_weight_limit = this->model->sampling_weight_limit();
+
+    const bool integral_sampling = !this->model->use_point_sampling();
+
+    this->nr_projection_cells = 0;
+    this->nr_sampling_cells = 0;
+
+    for (const scalar weight : this->relevant_cell_weights) {
+        if (weight > projection_weight_limit) {
+            this->nr_projection_cells++;
+        }
+
+        if (integral_sampling && weight > sampling_weight_limit) {
+            this->nr_sampling_cells++;
+        }
+    }
+}
+
+void Foam::fv::ActuatorLine::set_projection_data() {
+    this->set_body_force_field_weights();
+    this->set_projection_matrix();
+    this->set_projection_buffers();
+}
+
+/// Sizes the buffers used when the forces are projected at each time step
+void Foam::fv::ActuatorLine::set_projection_buffers() {
+    this->sectional_forces_to_project.resize(3 * this->model->nr_span_lines());
+
+    if (this->model->realign_to_local_velocity_at_each_cell()) {
+        this->realigned_body_forces.setSize(3 * this->relevant_cells.size());
+    } else {
+        this->realigned_body_forces.clearStorage();
+    }
+}
+
+/// Stores the projection weights in the body force fields used for post-processing, after the 
+/// relevant cells have changed
+void Foam::fv::ActuatorLine::set_body_force_field_weights() {
+    if (this->body_force_fields == BodyForceFields::dense) {
+        const double weight_limit = this->model->projection_weight_limit();
+
+        forAll(this->relevant_cells, i) {
+            if (this->relevant_cell_weights[i] > weight_limit) {
+                this->body_force_field_weight[0][this->relevant_cells[i]] = 
+                    this->relevant_cell_weights[i];
+            }
+        }
+    } else if (this->body_force_fields == BodyForceFields::sparse) {
+        this->projected_body_forces.setSize(this->relevant_cells.size());
+        this->projected_body_forces = vector::zero;
+    }
+}
+
+void Foam::fv::ActuatorLine::set_projection_matrix() {
+    const scalarField& cell_volumes = mesh_.V();
+
+    const labelList& cell_ids = this->relevant_cells;
+
+    label nr_rows = cell_ids.size();
+
+    // Rows for cells below the projection weight limit are left empty
+    const double weight_limit = this->model->projection_weight_limit();
+
+    auto is_projection_row = [&](label row) {
+        return this->relevant_cell_weights[row] > weight_limit;
+    };
+
+    ProjectionMatrix& matrix = this->projection_matrix;
+
+    matrix.row_offsets.setSize(nr_rows + 1);
+
+    // Only the values in the selected precision are stored, so that the other list takes no memory
+    const bool single_precision = this->single_precision_weights;
+
+    auto set_nr_entries = [&](label nr_entries) {
+        matrix.line_indices.setSize(nr_entries);
+
+        if (single_precision) {
+            matrix.values.clearStorage();
+            matrix.single_values.setSize(nr_entries);
+        } else {
+            matrix.single_values.clearStorage();
+            matrix.values.setSize(nr_entries);
+        }
+    };
+
+    auto set_value = [&](label k, scalar value) {
+        if (single_precision) {
+            matrix.single_values[k] = float(value);
+        } else {
+            matrix.values[k] = value;
+        }
+    };
+
+    if (this->model->blend_line_elements()) {
+        // The weights from each line element are stored for the candidate cells of each wing, 
+        // and only recomputed for the wings that have changed. The relevant cells are a subset of
+        // the candidate cells, and both these and the candidate cell entries from all wings are 
+        // sorted by cell label, so the entries for all rows are found in a single pass.
+        const std::vector<std::array<label, 3>>& entries = this->candidate_cell_entries;
+
+        auto for_each_row_entry = [&](auto&& func) {
+            std::size_t entry_index = 0;
+
+            for (label row = 0; row < nr_rows; row++) {
+                label cell_id = cell_ids[row];
+
+                while (entries[entry_index][0] < cell_id) {
+                    entry_index++;
+                }
+
+                if (!is_projection_row(row)) {
+                    continue;
+                }
+
+                for (
+                    std::size_t i = entry_index;
+                    i < entries.size() && entries[i][0] == cell_id;
+                    i++
+                ) {
+                    const WingProjectionData& wing_data = this->wing_projection_data[entries[i][1]];
+
+                    label wing_cell_index = entries[i][2];
+
+                    for (
+                        std::size_t wing_k = wing_data.line_weight_offsets[wing_cell_index];
+                        wing_k < wing_data.line_weight_offsets[wing_cell_index + 1];
+                        wing_k++
+                    ) {
+                        func(row, wing_data, wing_k);
+                    }
+                }
+            }
         };
 
-        double body_force_weight = this->model->summed_projection_weights_at_point(cell_center);
+        label nr_entries = 0;
+
+        for_each_row_entry([&](label, const WingProjectionData&, std::size_t) {
+            nr_entries++;
+        });
+
+        set_nr_entries(nr_entries);
+        matrix.row_offsets = 0;
+
+        label k = 0;
+
+        for_each_row_entry([&](label row, const WingProjectionData& wing_data, std::size_t wing_k) {
+            matrix.row_offsets[row + 1]++;
+            matrix.line_indices[k] = wing_data.line_weight_indices[wing_k];
+            set_value(k, wing_data.line_weights[wing_k] * cell_volumes[cell_ids[row]]);
+
+            k++;
+        });
+
+        for (label row = 0; row < nr_rows; row++) {
+            matrix.row_offsets[row + 1] += matrix.row_offsets[row];
+        }
+    } else {
+        // Only the dominating line element is used, together with the summed weight
+        set_nr_entries(this->nr_projection_cells);
+
+        label k = 0;
+
+        forAll(cell_ids, row) {
+            matrix.row_offsets[row] = k;
+
+            if (is_projection_row(row)) {
+                matrix.line_indices[k] = this->relevant_cell_line_indices[row];
+                set_value(k, this->relevant_cell_weights[row] * cell_volumes[cell_ids[row]]);
+
+                k++;
+            }
+        }
+
+        matrix.row_offsets[nr_rows] = k;
+    }
+}
+
+/// Writes a field with estimated computational weights for each cell, which can be used as the
+/// `weightField` when decomposing the mesh. All cells have a weight of one, and the weight factor 
+/// is added for each line element a cell receives forces from, and for cells that are used in the 
+/// velocity sampling. The resulting load on each processor is also reported.
+void Foam::fv::ActuatorLine::write_cell_weights(const scalar weight_factor) const {
+    volScalarField cell_weights(
+        IOobject(
+            "cellWeights",
+            mesh_.time().timeName(),
+            mesh_,
+            IOobject::NO_READ,
+            IOobject::NO_WRITE
+        ),
+        mesh_,
+        dimensionedScalar("cellWeights", dimless, 1.0)
+    );
+
+    const labelList& cell_ids = this->relevant_cells;
+    const ProjectionMatrix& matrix = this->projection_matrix;
+
+    const double sampling_weight_limit = this->model->sampling_weight_limit();
+    const bool integral_sampling = !this->model->use_point_sampling();
+
+    forAll(cell_ids, row) {
+        label nr_entries = matrix.row_offsets[row + 1] - matrix.row_offsets[row];
+
+        if (integral_sampling && this->relevant_cell_weights[row] > sampling_weight_limit) {
+            nr_entries++;
+        }
+
+        cell_weights[cell_ids[row]] += weight_factor * nr_entries;
+    }
+
+    cell_weights.write();
+
+    // Report the load on each processor with the current decomposition
+    scalar processor_weight = sum(cell_weights.primitiveField());
+
+    scalar max_weight = returnReduce(processor_weight, maxOp<scalar>());
+    scalar average_weight = returnReduce(processor_weight, sumOp<scalar>()) / Pstream::nProcs();
+
+    Info<< "Actuator line cell weights written to " << cell_weights.objectPath() << nl
+        << "    load imbalance with the current decomposition (max/avg): " 
+        << max_weight / average_weight << nl << endl;
+}
+
+void Foam::fv::ActuatorLine::project_forces(
+    const volVectorField& velocity_field, 
+    fvMatrix<vector>& eqn
+) {
+    const scalarField& cell_volumes = mesh_.V();
+    vectorField& equation_source = eqn.source();
+
+    const labelList& cell_ids = this->relevant_cells;
+
+    const ProjectionMatrix& matrix = this->projection_matrix;
 
-        if (body_force_weight > weight_limit) {
-            this->relevant_cells_for_projection.append(cell_id);
+    // Each row in the matrix belongs to a unique cell, so the rows can be computed independently 
+    if (this->model->realign_to_local_velocity_at_each_cell()) {
+        // The force direction depends on the local velocity, so it must be computed for each
+        // cell. Each chunk of rows is computed in a single call, directly from the velocity field.
+        const vectorField& velocity = velocity_field.primitiveField();
 
-            this->dominating_line_element_index_projection.append(
-                this->model->dominating_line_element_index_at_point(cell_center)
+        DynamicList<scalar>& body_forces = this->realigned_body_forces;
+
+        parallel_for(this->worker_pool, cell_ids.size(), [&](label start, label end, label) {
+            rust::Slice<double> chunk_body_forces(
+                body_forces.data() + 3 * start, 3 * (end - start)
             );
 
-            this->body_force_field_weight[0][cell_id] = body_force_weight;
+            if (this->single_precision_weights) {
+                this->model->realigned_body_forces_at_cells_single(
+                    as_slice(velocity),
+                    as_slice(cell_ids, start, end),
+                    as_slice(matrix.row_offsets, start, end + 1),
+                    as_slice(matrix.line_indices),
+                    as_slice(matrix.single_values),
+                    chunk_body_forces
+                );
+            } else {
+                this->model->realigned_body_forces_at_cells(
+                    as_slice(velocity),
+                    as_slice(cell_ids, start, end),
+                    as_slice(matrix.row_offsets, start, end + 1),
+                    as_slice(matrix.line_indices),
+                    as_slice(matrix.values),
+                    chunk_body_forces
+                );
+            }
+
+            for (label row = start; row < end; row++) {
+                label cell_id = cell_ids[row];
+
+                vector body_force(
+                    body_forces[3 * row], body_forces[3 * row + 1], body_forces[3 * row + 2]
+                );
+
+                equation_source[cell_id] += body_force;
+
+                this->store_body_force(row, cell_id, body_force / cell_volumes[cell_id]);
+            }
+        });
+    } else {
+        // The same sectional force is used in all cells, so the projection is a sparse 
+        // matrix-vector product
+        std::vector<double>& sectional_forces = this->sectional_forces_to_project;
+
+        this->model->get_sectional_forces_to_project(
+            rust::Slice<double>(sectional_forces.data(), sectional_forces.size())
+        );
+
+        // The same loop is used for values in both precisions. The products are computed in 
+        // double precision.
+        auto project_rows = [&](const auto& values) {
+            parallel_for(this->worker_pool, cell_ids.size(), [&](label start, label end, label) {
+                for (label row = start; row < end; row++) {
+                    label cell_id = cell_ids[row];
+
+                    vector body_force(vector::zero);
+
+                    for (label k = matrix.row_offsets[row]; k < matrix.row_offsets[row + 1]; k++) {
+                        const double* force = &sectional_forces[3 * matrix.line_indices[k]];
+                        const double value = values[k];
+
+                        body_force[0] += force[0] * value;
+                        body_force[1] += force[1] * value;
+                        body_force[2] += force[2] * value;
+                    }
+
+                    equation_source[cell_id] += body_force;
+
+                    this->store_body_force(row, cell_id, body_force / cell_volumes[cell_id]);
+                }
+            });
+        };
+
+        if (this->single_precision_weights) {
+            project_rows(matrix.single_values);
         } else {
-            this->body_force_field_weight[0][cell_id] = 0.0;
+            project_rows(matrix.values);
+        }
+    }
+}
+
+void Foam::fv::ActuatorLine::store_body_force(
+    const label row, 
+    const label cell_id, 
+    const vector& value
+) {
+    switch (this->body_force_fields) {
+        case BodyForceFields::dense:
+            this->body_force_field[0][cell_id] = value;
+            break;
+        case BodyForceFields::sparse:
+            this->projected_body_forces[row] = value;
+            break;
+        case BodyForceFields::none:
+            break;
+    }
+}
+
+/// Writes the body force and the projection weight in the cells used in the projection to the 
+/// current time directory, together with a cell set with the same cells, which can be used to view
+/// the values without storing full mesh fields. The values are given in the same order as the cell
+/// labels in `bodyForceCells`.
+void Foam::fv::ActuatorLine::write_sparse_body_force_fields() const {
+    const word time_name = mesh_.time().timeName();
+
+    auto io_object = [&](const word& name) {
+        return IOobject(name, time_name, mesh_, IOobject::NO_READ, IOobject::NO_WRITE, false);
+    };
+
+    // Relevant cells that are only used in the velocity sampling are left out
+    const double weight_limit = this->model->projection_weight_limit();
+
+    labelIOList cell_labels(io_object("bodyForceCells"), this->nr_projection_cells);
+    vectorIOField body_force(io_object("bodyForce"), this->nr_projection_cells);
+    scalarIOField body_force_weight(io_object("bodyForceWeight"), this->nr_projection_cells);
+
+    label k = 0;
+
+    forAll(this->relevant_cells, i) {
+        if (this->relevant_cell_weights[i] > weight_limit) {
+            cell_labels[k] = this->relevant_cells[i];
+            body_force[k] = this->projected_body_forces[i];
+            body_force_weight[k] = this->relevant_cell_weights[i];
+
+            k++;
         }
     }
+
+    cell_labels.write();
+    body_force.write();
+    body_force_weight.write();
+
+    cellSet cell_set(mesh_, "bodyForceCells", labelHashSet(cell_labels));
+
+    cell_set.instance() = time_name;
+    cell_set.write();
 }
@@ -0,0 +1,295 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+#include "fvMesh.H"
+#include "volFields.H"
+#include "IOdictionary.H"
+#include "OSHA1stream.H"
+
+#include <string>
+#include <vector>
+
+#include "actuator_line.hpp"
+
+#include "cpp_actuator_line.hpp"
+
+namespace {
+    /// The restart files are named after the fvOption entry, so that several actuatorLine 
+    /// entries in the same case do not overwrite each other's data
+    Foam::word restart_dictionary_name(const Foam::word& option_name) {
+        return Foam::word("stormbirdActuatorLine_" + option_name);
+    }
+
+    Foam::word restart_state_file_name(const Foam::word& option_name) {
+        return Foam::word("stormbird_restart_state_" + option_name + ".json");
+    }
+
+    Foam::word wing_dictionary_name(const Foam::label wing_index) {
+        return Foam::word("wing" + std::to_string(wing_index));
+    }
+
+    Foam::scalarList to_scalar_list(const std::vector<double>& values) {
+        Foam::scalarList list(values.size());
+
+        forAll(list, i) {
+            list[i] = values[i];
+        }
+
+        return list;
+    }
+
+    /// Weights stored in single precision are written as ordinary scalars, so that the restart
+    /// data can be read independently of the precision used when it was written
+    Foam::scalarList to_scalar_list(const Foam::UList<float>& values) {
+        Foam::scalarList list(values.size());
+
+        forAll(list, i) {
+            list[i] = values[i];
+        }
+
+        return list;
+    }
+
+    Foam::List<float> to_float_list(const Foam::scalarList& list) {
+        Foam::List<float> values(list.size());
+
+        forAll(list, i) {
+            values[i] = float(list[i]);
+        }
+
+        return values;
+    }
+
+    Foam::labelList to_label_list(const std::vector<std::size_t>& values) {
+        Foam::labelList list(values.size());
+
+        forAll(list, i) {
+            list[i] = values[i];
+        }
+
+        return list;
+    }
+
+    std::vector<double> to_vector(const Foam::scalarList& list) {
+        return std::vector<double>(list.begin(), list.end());
+    }
+
+    std::vector<std::size_t> to_index_vector(const Foam::labelList& list) {
+        return std::vector<std::size_t>(list.begin(), list.end());
+    }
+}
+
+/// Digest of the mesh topology on this processor. The cell centres are not included, as they are
+/// only written with limited precision for moving meshes, and would therefore not match exactly
+/// after a restart.
+Foam::SHA1Digest Foam::fv::ActuatorLine::mesh_digest() const {
+    OSHA1stream os;
+
+    os  << mesh_.nPoints() << mesh_.nCells()
+        << mesh_.faceOwner() << mesh_.faceNeighbour();
+
+    return os.digest();
+}
+
+/// Writes the state of the line force model, and the projection and sampling data for the cells
+/// on this processor, to the `uniform` folder in the current time directory. Each processor
+/// writes its own files, so that the data can be read again without any communication.
+void Foam::fv::ActuatorLine::write_restart_data() const {
+    const fileName restart_path = mesh_.time().timePath()/"uniform";
+
+    this->model->write_restart_state(restart_path/restart_state_file_name(this->name()));
+
+    IOdictionary restart_dict(
+        IOobject(
+            restart_dictionary_name(this->name()),
+            mesh_.time().timeName(),
+            "uniform",
+            mesh_,
+            IOobject::NO_READ,
+            IOobject::NO_WRITE,
+            false
+        )
+    );
+
+    restart_dict.add("meshDigest", this->mesh_digest());
+    restart_dict.add("geometryHash", word(std::to_string(this->model->geometry_hash())));
+    restart_dict.add("usePointSampling", this->model->use_point_sampling());
+
+    forAll(this->wing_projection_data, wing_index) {
+        const WingProjectionData& wing_data = this->wing_projection_data[wing_index];
+
+        dictionary wing_dict;
+
+        wing_dict.add("candidateBox", wing_data.candidate_box);
+        wing_dict.add("candidateCells", wing_data.candidate_cells);
+        wing_dict.add("summedWeights", to_scalar_list(wing_data.summed_weights));
+        wing_dict.add("maxWeights", to_scalar_list(wing_data.max_weights));
+        wing_dict.add("dominatingLineIndices", to_label_list(wing_data.dominating_line_indices));
+        wing_dict.add("wingAngle", wing_data.wing_angle);
+
+        if (this->model->blend_line_elements()) {
+            wing_dict.add("lineWeightOffsets", to_label_list(wing_data.line_weight_offsets));
+            wing_dict.add("lineWeightIndices", to_label_list(wing_data.line_weight_indices));
+            wing_dict.add("lineWeights", to_scalar_list(wing_data.line_weights));
+        }
+
+        restart_dict.add(wing_dictionary_name(wing_index), wing_dict);
+    }
+
+    restart_dict.add("relevantCells", this->relevant_cells);
+    restart_dict.add("relevantCellLineIndices", this->relevant_cell_line_indices);
+    restart_dict.add("relevantCellWeights", this->relevant_cell_weights);
+    restart_dict.add("projectionMatrixRowOffsets", this->projection_matrix.row_offsets);
+    restart_dict.add("projectionMatrixLineIndices", this->projection_matrix.line_indices);
+
+    if (this->single_precision_weights) {
+        restart_dict.add(
+            "projectionMatrixValues", to_scalar_list(this->projection_matrix.single_values)
+        );
+    } else {
+        restart_dict.add("projectionMatrixValues", this->projection_matrix.values);
+    }
+
+    if (this->single_precision_weights) {
+        restart_dict.add(
+            "velocitySamplingWeights", to_scalar_list(this->velocity_sampling_weights_single)
+        );
+    } else {
+        restart_dict.add("velocitySamplingWeights", this->velocity_sampling_weights);
+    }
+
+    restart_dict.regIOobject::write();
+}
+
+/// Reads the data written by [write_restart_data] from the current time directory, if it exists.
+/// The model state is used whenever it fits the model. The projection and sampling data is only
+/// used if the mesh and the geometry of the model are the same as when it was written, on all
+/// processors. Otherwise it is computed again at the first update. Returns true if the projection
+/// and sampling data was used.
+bool Foam::fv::ActuatorLine::read_restart_data() {
+    const fileName restart_path = mesh_.time().timePath()/"uniform";
+
+    bool state_is_restored = this->model->read_restart_state(
+        restart_path/restart_state_file_name(this->name())
+    );
+
+    reduce(state_is_restored, andOp<bool>());
+
+    if (state_is_restored) {
+        Info<< "Actuator line model state read from " << restart_path << endl;
+    }
+
+    IOobject restart_io(
+        restart_dictionary_name(this->name()),
+        mesh_.time().timeName(),
+        "uniform",
+        mesh_,
+        IOobject::MUST_READ,
+        IOobject::NO_WRITE,
+        false
+    );
+
+    autoPtr<IOdictionary> restart_dict;
+
+    bool data_is_valid = state_is_restored && restart_io.typeHeaderOk<IOdictionary>(true);
+
+    if (data_is_valid) {
+        restart_dict.reset(new IOdictionary(restart_io));
+
+        word geometry_hash(std::to_string(this->model->geometry_hash()));
+
+        // Data written before the projection and sampling shared the relevant cells is not used
+        data_is_valid =
+            restart_dict().found("relevantCells") &&
+            restart_dict().get<SHA1Digest>("meshDigest") == this->mesh_digest() &&
+            restart_dict().get<word>("geometryHash") == geometry_hash &&
+            restart_dict().get<bool>("usePointSampling") == this->model->use_point_sampling();
+
+        // The weights from each line element are needed to update single wings when the line 
+        // elements are blended
+        if (this->model->blend_line_elements()) {
+            forAll(this->wing_projection_data, wing_index) {
+                data_is_valid = data_is_valid && restart_dict().subOrEmptyDict(
+                    wing_dictionary_name(wing_index)
+                ).found("lineWeights");
+            }
+        }
+    }
+
+    reduce(data_is_valid, andOp<bool>());
+
+    if (!data_is_valid) {
+        Info<< "Actuator line projection and sampling data will be computed from scratch" << endl;
+
+        return false;
+    }
+
+    const dictionary& dict = restart_dict();
+
+    forAll(this->wing_projection_data, wing_index) {
+        WingProjectionData& wing_data = this->wing_projection_data[wing_index];
+
+        const dictionary& wing_dict = dict.subDict(wing_dictionary_name(wing_index));
+
+        wing_data.candidate_box = wing_dict.get<treeBoundBox>("candidateBox");
+        wing_data.candidate_cells = wing_dict.get<labelList>("candidateCells");
+        wing_data.summed_weights = to_vector(wing_dict.get<scalarList>("summedWeights"));
+        wing_data.max_weights = to_vector(wing_dict.get<scalarList>("maxWeights"));
+        wing_data.dominating_line_indices = to_index_vector(
+            wing_dict.get<labelList>("dominatingLineIndices")
+        );
+        wing_data.wing_angle = wing_dict.get<scalar>("wingAngle");
+        wing_data.outdated = false;
+
+        if (this->model->blend_line_elements()) {
+            wing_data.line_weight_offsets = to_index_vector(
+                wing_dict.get<labelList>("lineWeightOffsets")
+            );
+            wing_data.line_weight_indices = to_index_vector(
+                wing_dict.get<labelList>("lineWeightIndices")
+            );
+            wing_data.line_weights = to_vector(wing_dict.get<scalarList>("lineWeights"));
+        }
+    }
+
+    // Only combines the data from each wing, which is fast compared to computing the weights
+    this->set_candidate_cell_projection_weights();
+
+    this->relevant_cells = dict.get<labelList>("relevantCells");
+    this->relevant_cell_line_indices = dict.get<labelList>("relevantCellLineIndices");
+    this->relevant_cell_weights = dict.get<scalarList>("relevantCellWeights");
+
+    this->count_relevant_cells();
+    this->set_body_force_field_weights();
+
+    this->projection_matrix.row_offsets = dict.get<labelList>("projectionMatrixRowOffsets");
+    this->projection_matrix.line_indices = dict.get<labelList>("projectionMatrixLineIndices");
+
+    scalarList projection_matrix_values = dict.get<scalarList>("projectionMatrixValues");
+
+    if (this->single_precision_weights) {
+        this->projection_matrix.single_values = to_float_list(projection_matrix_values);
+    } else {
+        this->projection_matrix.values = projection_matrix_values;
+    }
+
+    this->set_projection_buffers();
+
+    if (this->model->use_point_sampling()) {
+        // Only depends on the control points, and is fast to compute
+        this->set_velocity_sampling_data_interpolation();
+    } else {
+        scalarList sampling_weights = dict.get<scalarList>("velocitySamplingWeights");
+
+        if (this->single_precision_weights) {
+            this->velocity_sampling_weights_single = to_float_list(sampling_weights);
+        } else {
+            this->velocity_sampling_weights = sampling_weights;
+        }
+    }
+
+    Info<< "Actuator line projection and sampling data read from " << restart_path << endl;
+
+    return true;
+}
@@ -8,159 +8,305 @@
 #include "addToRunTimeSelectionTable.H"
 #include "volFields.H"
 #include "interpolationCellPoint.H"
+#include "boundBox.H"
 
 #include "OFstream.H"
 
+#include <vector>
+
 #include "actuator_line.hpp"
+#include "field_views.hpp"
 
 #include "cpp_actuator_line.hpp"
 
+/// Computes the geometric sampling weights for all the relevant cells, with one call for each
+/// chunk of cells. Cells below the sampling weight limit get zero weight, so that the sums at each
+/// time step can loop over the same cells as the projection.
 void Foam::fv::ActuatorLine::set_velocity_sampling_data_integral() {
-    const vectorField& cell_centers = mesh_.C();
-    
-    const labelList& cell_ids = cells();
-
-    this->relevant_cells_for_velocity_sampling.clear();
-    this->dominating_line_element_index_sampling.clear();
-
-    this->relevant_cells_for_velocity_sampling = labelList();
-    this->dominating_line_element_index_sampling = labelList();
-
-    double weight_limit = this->model->sampling_weight_limit();
+    const vectorField& cell_centers = mesh_.C().primitiveField();
+    const scalarField& cell_volumes = mesh_.V();
 
-    forAll(cell_ids, i) {
-        label cell_id = cell_ids[i];
+    const labelList& cell_ids = this->relevant_cells;
 
-        std::array<double, 3> cell_center = {
-            cell_centers[cell_id][0],
-            cell_centers[cell_id][1],
-            cell_centers[cell_id][2]
-        };
+    label nr_cells = cell_ids.size();
 
-        double body_force_weight = this->model->summed_projection_weights_at_point(cell_center);
+    const double weight_limit = this->model->sampling_weight_limit();
 
-        if (body_force_weight > weight_limit) {
-            this->relevant_cells_for_velocity_sampling.append(cell_id);
+    auto remove_weights_below_limit = [&](auto& weights, label start, label end) {
+        for (label i = start; i < end; i++) {
+            if (this->relevant_cell_weights[i] <= weight_limit) {
+                weights[i] = 0.0;
+            }
+        }
+    };
+
+    // Only the list in the selected precision is kept, so that the other one takes no memory
+    if (this->single_precision_weights) {
+        this->velocity_sampling_weights.clearStorage();
+        this->velocity_sampling_weights_single.setSize(nr_cells);
+
+        parallel_for(this->worker_pool, nr_cells, [&](label start, label end, label) {
+            this->model->velocity_sampling_weights_at_cells_single(
+                as_slice(cell_centers),
+                as_slice(cell_volumes),
+                as_slice(cell_ids, start, end),
+                as_slice(this->relevant_cell_line_indices, start, end),
+                rust::Slice<float>(
+                    this->velocity_sampling_weights_single.data() + start, end - start
+                )
+            );
 
-            this->dominating_line_element_index_sampling.append(
-                this->model->dominating_line_element_index_at_point(cell_center)
+            remove_weights_below_limit(this->velocity_sampling_weights_single, start, end);
+        });
+    } else {
+        this->velocity_sampling_weights_single.clearStorage();
+        this->velocity_sampling_weights.setSize(nr_cells);
+
+        parallel_for(this->worker_pool, nr_cells, [&](label start, label end, label) {
+            this->model->velocity_sampling_weights_at_cells(
+                as_slice(cell_centers),
+                as_slice(cell_volumes),
+                as_slice(cell_ids, start, end),
+                as_slice(this->relevant_cell_line_indices, start, end),
+                rust::Slice<double>(this->velocity_sampling_weights.data() + start, end - start)
             );
 
-            this->body_force_field_weight[0][cell_id] = body_force_weight;
-        } else {
-            this->body_force_field_weight[0][cell_id] = 0.0;
-        }
+            remove_weights_below_limit(this->velocity_sampling_weights, start, end);
+        });
     }
 }
 
 void Foam::fv::ActuatorLine::set_velocity_sampling_data_interpolation() {
+    label nr_span_lines = this->model->nr_span_lines();
+
     this->ctrl_points.clear();
-    this->interpolation_cells.clear();
+
+    // The cell indices from the last update are only valid as long as the mesh topology is
+    // unchanged
+    if (this->ctrl_point_cells.size() != nr_span_lines || mesh_.topoChanging()) {
+        this->ctrl_point_cells.setSize(nr_span_lines);
+        this->ctrl_point_cells = -1;
+    }
+
+    labelList& interpolation_cells = this->ctrl_point_cells;
+
+    // The bounds of the part of the mesh on this processor, without syncing between processors,
+    // so that points on other processors can be rejected without searching
+    const boundBox local_bounds(mesh_.points(), false);
     
-    for (unsigned i = 0; i < this->model->nr_span_lines(); i++) {
+    // Mark all points found on this processor with the processor number, and all other points
+    // with a number larger than any processor number.
+    labelField processors_with_point(nr_span_lines, Pstream::nProcs());
+
+    for (label i = 0; i < nr_span_lines; i++) {
         std::array<double, 3> point_sb = this->model->get_ctrl_point_at_index(i);
         
         this->ctrl_points.push_back(
             vector(point_sb[0], point_sb[1], point_sb[2])
         );
 
-        this->interpolation_cells.push_back(
-            mesh_.findCell(this->ctrl_points[i])
+        interpolation_cells[i] = this->find_cell_from_guess(
+            this->ctrl_points[i], interpolation_cells[i], local_bounds
         );
+
+        if (interpolation_cells[i] != -1) {
+            processors_with_point[i] = Pstream::myProcNo();
+        }
     }
-}
 
+    // The lowest processor number that contains a point becomes the owner of that point
+    reduce(processors_with_point, minOp<labelField>());
 
-// --------------------- Perform the interpolation -------------------------------------------------
-void Foam::fv::ActuatorLine::set_integrated_weighted_velocity(const volVectorField& velocity_field) {
-    const vectorField& cell_centers = mesh_.C();
-    const scalarField& cell_volumes = mesh_.V();
+    this->ctrl_point_owners.setSize(nr_span_lines);
 
-    // Initialize the numerator and denominator
-    std::vector<vector> numerator;
-    std::vector<double> denominator;
+    this->ctrl_point_interpolation_weights.clear();
+    this->ctrl_point_interpolation_weights.setSize(nr_span_lines);
+    
+    for (label i = 0; i < nr_span_lines; i++) {
+        if (processors_with_point[i] < Pstream::nProcs()) {
+            this->ctrl_point_owners[i] = processors_with_point[i];
+        } else {
+            this->ctrl_point_owners[i] = -1;
+        }
+        
+        if (this->ctrl_point_owners[i] == Pstream::myProcNo()) {
+            this->ctrl_point_interpolation_weights.set(
+                i,
+                new cellPointWeight(mesh_, this->ctrl_points[i], interpolation_cells[i])
+            );
+        }
+    }
+}
 
-    int nr_span_lines = this->model->nr_span_lines();
 
-    for (int line_index = 0; line_index < nr_span_lines; line_index++) {
-        numerator.push_back(vector::zero);
-        denominator.push_back(0.0);
+/// Finds the cell containing the input point by walking through face neighbours, starting from the
+/// guessed cell. At each step, the walk moves through the face that the point is furthest outside 
+/// of. This is usually only a few steps, as the control points move a fraction of a cell between 
+/// each update. Points outside the bounds of the mesh on this processor are rejected directly. 
+/// The full octree search is used when there is no guess, or when the walk fails, for instance 
+/// when it leaves through a boundary. A straight walk can leave a non-convex processor domain, or
+/// pass through a cyclic patch, even if the point is on this processor, so the walk alone can not 
+/// decide that the point is missing.
+Foam::label Foam::fv::ActuatorLine::find_cell_from_guess(
+    const vector& point, 
+    const label cell_guess,
+    const boundBox& local_bounds
+) const {
+    if (!local_bounds.contains(point)) {
+        return -1;
     }
 
-    // Loop over all cells for the current processor
-    forAll(this->relevant_cells_for_velocity_sampling, i) {
-        label cell_id = this->relevant_cells_for_velocity_sampling[i];
-
-        std::array<double, 3> velocity = {
-            velocity_field[cell_id][0],
-            velocity_field[cell_id][1],
-            velocity_field[cell_id][2]
-        };
-
-        double cell_volume = cell_volumes[cell_id];
-       
-        std::array<double, 3> cell_center = {
-            cell_centers[cell_id][0],
-            cell_centers[cell_id][1],
-            cell_centers[cell_id][2]
-        };
-
-        auto line_index = this->dominating_line_element_index_sampling[i];
-        
-        std::array<double, 4> temp_out = this->model->get_weighted_velocity_sampling_integral_terms_for_cell(
-            line_index,
-            velocity,
-            cell_center,
-            cell_volume
-        );
-
-        numerator[line_index][0] += temp_out[0];
-        numerator[line_index][1] += temp_out[1];
-        numerator[line_index][2] += temp_out[2];
-        denominator[line_index] += temp_out[3];
+    if (cell_guess < 0 || cell_guess >= mesh_.nCells()) {
+        return mesh_.findCell(point);
     }
 
-    // Sync the values between processors
-    for (int line_index = 0; line_index < nr_span_lines; line_index++) {
-        reduce(numerator[line_index], sumOp<vector>());
-        reduce(denominator[line_index], sumOp<double>());
+    const labelList& owner = mesh_.faceOwner();
+    const labelList& neighbour = mesh_.faceNeighbour();
+    const vectorField& face_centres = mesh_.faceCentres();
+    const vectorField& face_areas = mesh_.faceAreas();
+
+    const label max_nr_steps = 100;
+
+    label cell_id = cell_guess;
+
+    for (label step = 0; step < max_nr_steps; step++) {
+        if (mesh_.pointInCell(point, cell_id)) {
+            return cell_id;
+        }
+
+        // Find the face that the point is furthest outside of
+        const cell& cell_faces = mesh_.cells()[cell_id];
+
+        label exit_face = -1;
+        scalar max_distance = 0.0;
+
+        forAll(cell_faces, i) {
+            label face_id = cell_faces[i];
+
+            vector outward_normal = face_areas[face_id] / (mag(face_areas[face_id]) + VSMALL);
+
+            if (owner[face_id] != cell_id) {
+                outward_normal = -outward_normal;
+            }
+
+            scalar distance = (point - face_centres[face_id]) & outward_normal;
+
+            if (distance > max_distance) {
+                max_distance = distance;
+                exit_face = face_id;
+            }
+        }
+
+        // The point is inside all face planes, but not in the cell according to the cell
+        // decomposition, or outside a boundary face. 
+        if (exit_face == -1 || !mesh_.isInternalFace(exit_face)) {
+            break;
+        }
+
+        cell_id = (owner[exit_face] == cell_id) ? neighbour[exit_face] : owner[exit_face];
     }
 
-    // Set the values in the model 
-    for (int line_index = 0; line_index < nr_span_lines; line_index++) {
-        if (denominator[line_index] != 0.0) {
-            std::array<double, 3> velocity = {
-                numerator[line_index][0] / denominator[line_index],
-                numerator[line_index][1] / denominator[line_index],
-                numerator[line_index][2] / denominator[line_index]
-            };
+    return mesh_.findCell(point);
+}
+
+// --------------------- Perform the interpolation -------------------------------------------------
+/// Computes the sums used in the integral velocity sampling from the cells on this processor. The
+/// numerator and denominator for all line elements are stored in the sampling buffer, so that 
+/// they can be synced between processors in a single reduction. The first part contains the 
+/// three components of the numerator for each line element, and the last part contains the 
+/// denominator.
+void Foam::fv::ActuatorLine::compute_integrated_sampling_sums(const volVectorField& velocity_field) {
+    int nr_span_lines = this->model->nr_span_lines();
+
+    scalarField& sampling_sums = this->sampling_buffer;
+
+    sampling_sums.setSize(4 * nr_span_lines);
+    sampling_sums = 0.0;
+
+    const labelList& cell_ids = this->relevant_cells;
+
+    const vectorField& velocity = velocity_field.primitiveField();
+
+    // Each chunk of cells accumulates into its own buffer, which are merged before the sync
+    label nr_chunks = nr_loop_chunks(this->worker_pool.nr_threads(), cell_ids.size());
+
+    std::vector<scalarField> chunk_sums(nr_chunks - 1, scalarField(4 * nr_span_lines, 0.0));
 
-            this->model->set_velocity_at_index(line_index, velocity);
+    parallel_for(this->worker_pool, cell_ids.size(), [&](label start, label end, label chunk) {
+        scalarField& sums = (chunk == 0) ? sampling_sums : chunk_sums[chunk - 1];
+
+        if (this->single_precision_weights) {
+            this->model->add_weighted_velocity_sampling_sums_single(
+                as_slice(velocity),
+                as_slice(cell_ids, start, end),
+                as_slice(this->relevant_cell_line_indices, start, end),
+                as_slice(this->velocity_sampling_weights_single, start, end),
+                as_mut_slice(sums)
+            );
+        } else {
+            this->model->add_weighted_velocity_sampling_sums(
+                as_slice(velocity),
+                as_slice(cell_ids, start, end),
+                as_slice(this->relevant_cell_line_indices, start, end),
+                as_slice(this->velocity_sampling_weights, start, end),
+                as_mut_slice(sums)
+            );
         }
-        
+    });
+
+    for (const scalarField& sums : chunk_sums) {
+        sampling_sums += sums;
     }
 }
 
-void Foam::fv::ActuatorLine::set_interpolated_velocity(const volVectorField& velocity_field) {    
-    interpolationCellPoint<vector> u_interpolator(velocity_field); // create interpolation object
+/// Sets the velocity in the model from the sampling sums, after they are summed over all 
+/// processors
+void Foam::fv::ActuatorLine::set_integrated_weighted_velocity() {
+    this->model->set_velocity_from_sampling_sums(as_slice(this->sampling_buffer));
+}
+
+/// Interpolates the velocity at the control points owned by this processor. All other processors
+/// contribute zeros, so that the samples can be synced between processors in a single reduction.
+void Foam::fv::ActuatorLine::compute_interpolated_samples(const volVectorField& velocity_field) {
+    label nr_span_lines = this->model->nr_span_lines();
+
+    // The point values of the velocity field must be updated at every call, but the interpolation
+    // weights at the control points are reused from the last geometry update.
+    interpolationCellPoint<vector> u_interpolator(velocity_field);
+
+    scalarField& samples = this->sampling_buffer;
 
-    for (unsigned int i = 0; i < this->ctrl_points.size(); i++) {
-        vector u_sample = vector(VGREAT, VGREAT, VGREAT);
+    samples.setSize(3 * nr_span_lines);
+    samples = 0.0;
 
-        label cell_id = this->interpolation_cells[i];
+    for (label i = 0; i < nr_span_lines; i++) {
+        if (this->ctrl_point_interpolation_weights.set(i)) {
+            vector u_sample = u_interpolator.interpolate(this->ctrl_point_interpolation_weights[i]);
 
-        if (this->interpolation_cells[i] != -1) {
-            u_sample = u_interpolator.interpolate(this->ctrl_points[i], cell_id);
+            samples[3 * i]     = u_sample[0];
+            samples[3 * i + 1] = u_sample[1];
+            samples[3 * i + 2] = u_sample[2];
         }
-        
-        reduce(u_sample, minOp<vector>());
+    }
+}
 
-        std::array<double, 3> velocity = {
-            u_sample[0],
-            u_sample[1],
-            u_sample[2]
-        };
+/// Sets the velocity in the model from the interpolated samples, after they are summed over all
+/// processors
+void Foam::fv::ActuatorLine::set_interpolated_velocity() {
+    label nr_span_lines = this->model->nr_span_lines();
 
-        this->model->set_velocity_at_index(i, velocity);
+    const scalarField& samples = this->sampling_buffer;
+
+    // Points outside the mesh keep their previous velocity in the model
+    for (label i = 0; i < nr_span_lines; i++) {
+        if (this->ctrl_point_owners[i] != -1) {
+            std::array<double, 3> velocity = {
+                samples[3 * i],
+                samples[3 * i + 1],
+                samples[3 * i + 2]
+            };
+
+            this->model->set_velocity_at_index(i, velocity);
+        }
     }
- }
+}
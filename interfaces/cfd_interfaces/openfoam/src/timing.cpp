@@ -0,0 +1,109 @@
+// Copyright (C) 2024, NTNU 
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+#include "Pstream.H"
+#include "scalarField.H"
+#include "OSspecific.H"
+
+#include <fstream>
+
+#include "timing.hpp"
+
+const std::array<const char*, Foam::fv::ActuatorLineTiming::nr_phases> 
+Foam::fv::ActuatorLineTiming::phase_names = {
+    "syncState",
+    "geometryUpdate",
+    "velocitySampling",
+    "samplingCommunication",
+    "solve",
+    "forceSync",
+    "forceProjection",
+    "output"
+};
+
+void Foam::fv::ActuatorLineTiming::report(
+    const fileName& folder_path,
+    const scalar time,
+    const label nr_projection_cells,
+    const label nr_sampling_cells
+) const {
+    // All values from this processor are packed in one field, so that the statistics across 
+    // processors can be computed with one reduction for each statistic
+    const label nr_values = nr_phases + 2;
+
+    scalarField values(nr_values);
+
+    for (label phase = 0; phase < nr_phases; phase++) {
+        values[phase] = this->seconds[phase];
+    }
+
+    values[nr_phases] = nr_projection_cells;
+    values[nr_phases + 1] = nr_sampling_cells;
+
+    scalarField min_values(values);
+    scalarField max_values(values);
+    scalarField avg_values(values);
+
+    reduce(min_values, minOp<scalarField>());
+    reduce(max_values, maxOp<scalarField>());
+    reduce(avg_values, sumOp<scalarField>());
+
+    avg_values /= scalar(Pstream::nProcs());
+
+    if (!Pstream::master()) {
+        return;
+    }
+
+    Info<< "Actuator line timing at time = " << time << nl
+        << "    phase: calls, min [s], max [s], avg [s], max/avg" << nl;
+
+    for (label phase = 0; phase < nr_phases; phase++) {
+        scalar imbalance = avg_values[phase] > 0 ? max_values[phase] / avg_values[phase] : 1.0;
+
+        Info<< "    " << word(phase_names[phase]) 
+            << ": " << this->calls[phase]
+            << ", " << min_values[phase]
+            << ", " << max_values[phase]
+            << ", " << avg_values[phase] 
+            << ", " << imbalance << nl;
+    }
+
+    Info<< "    relevant projection cells per processor (min, max, avg): " 
+        << min_values[nr_phases] << ", " 
+        << max_values[nr_phases] << ", " 
+        << avg_values[nr_phases] << nl
+        << "    relevant sampling cells per processor (min, max, avg): " 
+        << min_values[nr_phases + 1] << ", " 
+        << max_values[nr_phases + 1] << ", " 
+        << avg_values[nr_phases + 1] << nl << endl;
+
+    mkDir(folder_path);
+
+    const fileName file_path = folder_path/"actuatorLineTiming.csv";
+
+    const bool write_header = !isFile(file_path);
+
+    std::ofstream file(file_path.c_str(), std::ios::app);
+
+    if (write_header) {
+        file << "time";
+
+        for (label phase = 0; phase < nr_phases; phase++) {
+            file << "," << phase_names[phase] << "_min"
+                 << "," << phase_names[phase] << "_max"
+                 << "," << phase_names[phase] << "_avg";
+        }
+
+        file << ",projectionCells_min,projectionCells_max,projectionCells_avg"
+             << ",samplingCells_min,samplingCells_max,samplingCells_avg\n";
+    }
+
+    file << time;
+
+    for (label i = 0; i < nr_values; i++) {
+        file << "," << min_values[i] << "," << max_values[i] << "," << avg_values[i];
+    }
+
+    file << "\n";
+}
@@ -0,0 +1,83 @@
+// Copyright (C) 2024, NTNU 
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+///
+/// Simple wall-clock timing of the different phases in the actuator line model, used to see where
+/// the time is spent, and how the load is balanced between processors.
+/// 
+
+#ifndef ACTUATOR_LINE_TIMING_H
+#define ACTUATOR_LINE_TIMING_H
+
+#include "label.H"
+#include "scalar.H"
+#include "fileName.H"
+
+#include <array>
+#include <chrono>
+
+namespace Foam {
+    namespace fv {
+        class ActuatorLineTiming {
+        public:
+            /// The phases that are timed
+            enum Phase {
+                sync_state,
+                geometry_update,
+                velocity_sampling,
+                sampling_communication,
+                solve,
+                force_sync,
+                force_projection,
+                output,
+                nr_phases
+            };
+
+            static const std::array<const char*, nr_phases> phase_names;
+
+            /// Adds the time between construction and destruction to the input phase
+            class ScopedTimer {
+            public:
+                ScopedTimer(ActuatorLineTiming& timing, const Phase phase):
+                    timing(timing), 
+                    phase(phase), 
+                    start(std::chrono::steady_clock::now()) 
+                {}
+
+                ~ScopedTimer() {
+                    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+                    timing.add(phase, duration.count());
+                }
+
+            private:
+                ActuatorLineTiming& timing;
+                const Phase phase;
+                const std::chrono::steady_clock::time_point start;
+            };
+
+            void add(const Phase phase, const double seconds) {
+                this->seconds[phase] += seconds;
+                this->calls[phase]++;
+            }
+
+            /// Writes the cumulative time for each phase, together with the number of relevant 
+            /// cells, to the log and to a csv file in the input folder. The minimum, maximum and 
+            /// average values across all processors are reported. Must be called on all 
+            /// processors.
+            void report(
+                const fileName& folder_path,
+                const scalar time,
+                const label nr_projection_cells,
+                const label nr_sampling_cells
+            ) const;
+
+        private:
+            std::array<double, nr_phases> seconds{};
+            std::array<label, nr_phases> calls{};
+        };
+    }
+}
+
+#endif
@@ -19,6 +19,7 @@ from pystormbird import section_models
 from pystormbird import line_force_model
 from pystormbird import wind
 from pystormbird import smoothing
+from pystormbird import result_stream
 
 __all__ = [
     "SimulationResult",
@@ -28,4 +29,5 @@ __all__ = [
     "line_force_model",
     "wind",
     "smoothing",
+    "result_stream",
 ]
\ No newline at end of file
@@ -0,0 +1,71 @@
+"""
+Copyright (C) 2024, NTNU
+Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+Reader for the binary result stream written by the actuator line model when
+`write_binary_results` is enabled. The file is memory mapped, so that single fields or time steps
+can be sliced out without loading the whole file.
+"""
+
+import json
+import os
+
+import numpy as np
+
+MAGIC = b"SBRESULT"
+
+class ResultStream:
+    """
+    Memory mapped view of a result stream file. Each record is one time step, and the fields are
+    available by the same names as in the SimulationResult structure, with a dot between nested
+    names. For instance, `stream["force_input.circulation_strength"]` returns an array with shape
+    (nr_records, nr_span_lines).
+    """
+    def __init__(self, file_path: str):
+        with open(file_path, "rb") as file:
+            magic = file.read(8)
+
+            if magic != MAGIC:
+                raise ValueError(f"{file_path} is not a Stormbird result stream")
+
+            header_length = int.from_bytes(file.read(8), "little")
+
+            self.header = json.loads(file.read(header_length))
+
+        self.dtype = np.dtype([
+            (field["name"], "<f8", tuple(field["shape"])) for field in self.header["fields"]
+        ])
+
+        if self.dtype.itemsize != 8 * self.header["record_length"]:
+            raise ValueError(f"Inconsistent record layout in {file_path}")
+
+        data_offset = 16 + header_length
+
+        # An incomplete record at the end, from a simulation that is still running, is ignored
+        nr_records = (os.path.getsize(file_path) - data_offset) // self.dtype.itemsize
+
+        if nr_records > 0:
+            self.records = np.memmap(
+                file_path, dtype=self.dtype, mode="r", offset=data_offset, shape=(nr_records,)
+            )
+        else:
+            self.records = np.empty(0, dtype=self.dtype)
+
+    @property
+    def field_names(self) -> list[str]:
+        return [field["name"] for field in self.header["fields"]]
+
+    @property
+    def nr_span_lines(self) -> int:
+        return self.header["nr_span_lines"]
+
+    @property
+    def wing_indices(self) -> list[range]:
+        return [range(start, end) for start, end in self.header["wing_indices"]]
+
+    def __len__(self) -> int:
+        return len(self.records)
+
+    def __getitem__(self, field_name: str) -> np.ndarray:
+        return self.records[field_name]
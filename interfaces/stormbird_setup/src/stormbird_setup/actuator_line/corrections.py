@@ -12,6 +12,7 @@ class LiftingLineCorrectionBuilder(StormbirdSetupBaseModel):
     wake_length_factor: float = 100.0
     symmetry_condition: SymmetryCondition = SymmetryCondition.NoSymmetry
     initialization_time: float | None = None
+    wake_direction_tolerance: float = 0.0
 
 class EmpiricalCirculationCorrection(StormbirdSetupBaseModel):
     exp_factor: float = 10.0
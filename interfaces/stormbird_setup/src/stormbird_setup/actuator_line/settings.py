@@ -4,6 +4,8 @@ Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
 License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
 """
 
+from enum import Enum
+
 from ..base_model import StormbirdSetupBaseModel
 
 class Gaussian(StormbirdSetupBaseModel):
@@ -16,6 +18,7 @@ class ProjectionSettings(StormbirdSetupBaseModel):
     realign_to_local_velocity_at_each_cell: bool = False
     project_viscous_lift: bool = False
     project_sectional_drag: bool = False
+    blend_line_elements: bool = False
 
 class SamplingSettings(StormbirdSetupBaseModel):
     use_point_sampling: bool = False
@@ -25,5 +28,12 @@ class SamplingSettings(StormbirdSetupBaseModel):
     remove_span_velocity: bool = False
     correction_factor: float = 1.0
 
+class ForceInterpolation(Enum):
+    Hold = "Hold"
+    Linear = "Linear"
+
 class SolverSettings(StormbirdSetupBaseModel):
     damping_factor: float = 0.1
+    solve_interval: int = 1
+    solve_time_interval: float | None = None
+    force_interpolation: ForceInterpolation = ForceInterpolation.Hold
@@ -0,0 +1,102 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+//! Functionality for moving an actuator line model together with a CFD mesh that moves as a rigid
+//! body. The motion of the mesh is given relative to a reference, so that the geometry of the
+//! model relative to the mesh stays the same, and data that only depends on this relative geometry
+//! can be reused in the CFD solver.
+
+use stormath::spatial_vector::SpatialVector;
+use stormath::type_aliases::Float;
+use stormath::rigid_body_motion::RigidBodyMotion;
+
+use super::ActuatorLine;
+
+#[derive(Debug, Clone)]
+/// The rigid body motion of the model at the time when the reference was set, given as a rotation
+/// matrix and a translation.
+pub struct BodyFrameReference {
+    /// The columns of the rotation matrix, which are the rotated unit vectors
+    pub rotation_axes: [SpatialVector; 3],
+    pub translation: SpatialVector,
+}
+
+impl BodyFrameReference {
+    pub fn from_motion(motion: &RigidBodyMotion) -> Self {
+        Self {
+            rotation_axes: [
+                motion.transform_vector(SpatialVector::unit_x()),
+                motion.transform_vector(SpatialVector::unit_y()),
+                motion.transform_vector(SpatialVector::unit_z()),
+            ],
+            translation: motion.translation,
+        }
+    }
+}
+
+/// Returns the rotation vector that gives the input rotation matrix, where the matrix is given as
+/// rows. Both rotation types in the rigid body motion correspond to the rotation matrix
+/// Rz * Ry * Rx, so the same angles are used for both.
+pub fn rotation_from_matrix(matrix: &[[Float; 3]; 3]) -> SpatialVector {
+    let sin_y = (-matrix[2][0]).clamp(-1.0, 1.0);
+
+    SpatialVector::from([
+        matrix[2][1].atan2(matrix[2][2]),
+        sin_y.asin(),
+        matrix[1][0].atan2(matrix[0][0]),
+    ])
+}
+
+impl ActuatorLine {
+    /// Stores the current rigid body motion of the model as the reference for the body frame
+    /// motion.
+    pub fn set_body_frame_reference(&mut self) {
+        self.body_frame_reference = Some(
+            BodyFrameReference::from_motion(&self.line_force_model.rigid_body_motion)
+        );
+    }
+
+    /// Moves the model with a rigid transformation relative to the reference. The rotation matrix
+    /// is given as rows, and is applied before the translation. The velocity of the motion is
+    /// computed with a finite difference from the previous position, so this should only be called
+    /// once per time step. The reference is set from the current motion if it does not exist.
+    pub fn move_with_body_frame(
+        &mut self,
+        rotation_matrix: [[Float; 3]; 3],
+        translation: SpatialVector,
+        time_step: Float
+    ) {
+        if self.body_frame_reference.is_none() {
+            self.set_body_frame_reference();
+        }
+
+        let reference = self.body_frame_reference.as_ref().unwrap();
+
+        let rotate = |vector: SpatialVector| -> SpatialVector {
+            SpatialVector::from([
+                rotation_matrix[0][0] * vector[0] + rotation_matrix[0][1] * vector[1] + rotation_matrix[0][2] * vector[2],
+                rotation_matrix[1][0] * vector[0] + rotation_matrix[1][1] * vector[1] + rotation_matrix[1][2] * vector[2],
+                rotation_matrix[2][0] * vector[0] + rotation_matrix[2][1] * vector[1] + rotation_matrix[2][2] * vector[2],
+            ])
+        };
+
+        let rotated_axes = reference.rotation_axes.map(rotate);
+
+        let mut total_rotation_matrix = [[0.0; 3]; 3];
+
+        for i in 0..3 {
+            for j in 0..3 {
+                total_rotation_matrix[i][j] = rotated_axes[j][i];
+            }
+        }
+
+        let total_translation = rotate(reference.translation) + translation;
+
+        self.line_force_model.set_translation_and_rotation_with_finite_difference_for_the_velocity(
+            time_step,
+            total_translation,
+            rotation_from_matrix(&total_rotation_matrix)
+        );
+    }
+}
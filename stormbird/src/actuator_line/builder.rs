@@ -13,9 +13,11 @@ use stormath::type_aliases::Float;
 
 use super::projection::ProjectionSettings;
 use super::sampling::SamplingSettings;
-use super::solver::SolverSettings;
+use super::solver::{SolverSettings, SubStepState, SolverWorkspace};
 use super::ActuatorLine;
 
+use crate::common_utils::results::result_stream::LazyResultStream;
+
 use super::corrections::{
     lifting_line::LiftingLineCorrectionBuilder,
     empirical_circulation::EmpiricalCirculationCorrection,
@@ -36,6 +38,8 @@ pub struct ActuatorLineBuilder {
     #[serde(default="ActuatorLineBuilder::default_write_iterations_full_result")]
     pub write_iterations_full_result: usize,
     #[serde(default)]
+    pub write_binary_results: bool,
+    #[serde(default)]
     pub start_time: Float,
     #[serde(default)]
     pub controller: Option<ControllerBuilder>,
@@ -61,6 +65,7 @@ impl ActuatorLineBuilder {
             sampling_settings: SamplingSettings::default(),
             controller: None,
             write_iterations_full_result: Self::default_write_iterations_full_result(),
+            write_binary_results: false,
             start_time: 0.0,
             lifting_line_correction: None,
             empirical_circulation_correction: None,
@@ -101,12 +106,17 @@ impl ActuatorLineBuilder {
             start_time: self.start_time,
             current_iteration: 0,
             write_iterations_full_result: self.write_iterations_full_result,
+            write_binary_results: self.write_binary_results,
+            result_stream: LazyResultStream::default(),
             ctrl_points_velocity: vec![SpatialVector::default(); nr_span_lines],
             simulation_result: None,
             sectional_lift_forces_to_project: vec![SpatialVector::default(); nr_span_lines],
             sectional_drag_forces_to_project: vec![SpatialVector::default(); nr_span_lines],
             lifting_line_correction,
             empirical_circulation_correction: self.empirical_circulation_correction.clone(),
+            sub_step_state: SubStepState::default(),
+            workspace: SolverWorkspace::default(),
+            body_frame_reference: None,
         }
     }
 }
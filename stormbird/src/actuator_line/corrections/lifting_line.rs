@@ -6,6 +6,7 @@ use crate::lifting_line::wake::frozen_wake::FrozenWake;
 use crate::lifting_line::singularity_elements::symmetry_condition::SymmetryCondition;
 
 use crate::line_force_model::LineForceModel;
+use crate::line_force_model::span_line::SpanLine;
 
 use stormath::spatial_vector::SpatialVector;
 use stormath::type_aliases::Float;
@@ -23,7 +24,11 @@ pub struct LiftingLineCorrectionBuilder {
     #[serde(default)]
     pub symmetry_condition: SymmetryCondition,
     #[serde(default)]
-    pub initialization_time: Option<Float>
+    pub initialization_time: Option<Float>,
+    #[serde(default)]
+    /// Angle, in radians, that the averaged inflow direction on a wing can change before the 
+    /// induced velocity factors for that wing are recomputed.
+    pub wake_direction_tolerance: Float,
 }
 
 impl Default for LiftingLineCorrectionBuilder {
@@ -31,7 +36,8 @@ impl Default for LiftingLineCorrectionBuilder {
         Self {
             wake_length_factor: Self::default_wake_length_factor(),
             symmetry_condition: SymmetryCondition::NoSymmetry,
-            initialization_time: None
+            initialization_time: None,
+            wake_direction_tolerance: 0.0,
         }
     }
 }
@@ -55,6 +61,8 @@ impl LiftingLineCorrectionBuilder {
             wake_length_factor: self.wake_length_factor,
             symmetry_condition: self.symmetry_condition,
             initialization_time: self.initialization_time,
+            wake_direction_tolerance: self.wake_direction_tolerance,
+            wing_corrections: vec![None; line_force_model.nr_wings()],
         }
     }
 }
@@ -72,23 +80,94 @@ pub struct LiftingLineCorrection {
     pub wake_length_factor: Float,
     pub symmetry_condition: SymmetryCondition,
     pub initialization_time: Option<Float>,
+    pub wake_direction_tolerance: Float,
+    /// Stored data for each wing, so that the induced velocity factors are only computed when
+    /// necessary.
+    wing_corrections: Vec<Option<WingCorrection>>,
+}
+
+#[derive(Debug, Clone)]
+/// The induced velocity factors for the correction on a single wing, together with the data they
+/// were computed from. The factors only depend on the span lines and the wake direction.
+struct WingCorrection {
+    span_lines: Vec<SpanLine>,
+    wake_direction: SpatialVector,
+    /// Frozen wake where the velocity factors are the difference between the factors with a small 
+    /// viscous core and the factors with the full viscous core.
+    frozen_wake: FrozenWake,
+}
+
+impl WingCorrection {
+    /// Checks if the stored factors are still valid for the input span lines and wake direction
+    fn is_valid(
+        &self, 
+        span_lines: &[SpanLine], 
+        wake_direction: SpatialVector,
+        wake_direction_tolerance: Float
+    ) -> bool {
+        if self.span_lines.len() != span_lines.len() {
+            return false;
+        }
+
+        for (stored_line, line) in self.span_lines.iter().zip(span_lines.iter()) {
+            if stored_line.start_point != line.start_point || stored_line.end_point != line.end_point {
+                return false;
+            }
+        }
+
+        if wake_direction == self.wake_direction {
+            return true;
+        }
+
+        self.wake_direction.dot(wake_direction) >= wake_direction_tolerance.cos()
+    }
 }
 
 impl LiftingLineCorrection {
     /// Computes a difference in the induced velocities between two lifting line simulations; one
     /// with a viscous core length equal to the force projection width, and one with a small viscous
     /// core length. The difference is then returned as a vector of induced velocities at the control
-    /// points of the line force model
+    /// points of the line force model.
+    ///
+    /// The induced velocity factors for each wing are stored, and only recomputed when the span
+    /// lines change, or when the wake direction changes by more than the wake direction tolerance.
     pub fn velocity_correction(
-        &self,
+        &mut self,
         line_force_model: &LineForceModel,
         ctrl_points_velocity: &[SpatialVector],
         circulation_strength: &[Float],
         time: Float,
     ) -> Vec<SpatialVector> {
+        let mut u_i_correction = vec![SpatialVector::default(); ctrl_points_velocity.len()];
+
+        self.add_velocity_correction(
+            line_force_model, 
+            ctrl_points_velocity, 
+            circulation_strength, 
+            time, 
+            &mut u_i_correction
+        );
+
+        u_i_correction
+    }
+
+    /// Same as [LiftingLineCorrection::velocity_correction], but the correction is added directly
+    /// to the input velocity, without allocating a new vector.
+    pub fn add_velocity_correction(
+        &mut self,
+        line_force_model: &LineForceModel,
+        ctrl_points_velocity: &[SpatialVector],
+        circulation_strength: &[Float],
+        time: Float,
+        velocity: &mut [SpatialVector],
+    ) {
         let span_lines = &line_force_model.span_lines_global;
 
-        let mut u_i_correction: Vec<SpatialVector> = Vec::with_capacity(span_lines.len());
+        let correction_factor = if let Some(initialization_time) = self.initialization_time {
+            cosine_transition_zero_to_one(time, 0.0, initialization_time)
+        } else {
+            1.0
+        };
 
         for wing_index in 0..line_force_model.nr_wings() {
             let wind_indices = line_force_model.wing_indices[wing_index].clone();
@@ -110,46 +189,68 @@ impl LiftingLineCorrection {
             let averaged_ctrl_points_velocity = wing_ctrl_points_velocity.iter().sum::<SpatialVector>()
                 / wing_ctrl_points_velocity.len() as Float;
 
-            let wake_vector = averaged_ctrl_points_velocity.normalize() * self.wake_length_factor;
+            let wake_direction = averaged_ctrl_points_velocity.normalize();
 
-            let mut frozen_wake_viscous = FrozenWake::steady_wake_for_single_wing_from_span_lines_and_direction(
-                wing_span_lines,
-                wake_vector,
-                self.viscous_core_length,
-                self.symmetry_condition
+            let is_valid = self.wing_corrections[wing_index].as_ref().is_some_and(
+                |correction| correction.is_valid(
+                    wing_span_lines, wake_direction, self.wake_direction_tolerance
+                )
             );
 
-            let mut frozen_wake_default = FrozenWake::steady_wake_for_single_wing_from_span_lines_and_direction(
-                wing_span_lines,
-                wake_vector,
-                self.viscous_core_length / 100.0,
-                self.symmetry_condition
-            );
+            if !is_valid {
+                self.wing_corrections[wing_index] = Some(
+                    self.wing_correction(wing_span_lines, wake_direction)
+                );
+            }
 
-            frozen_wake_viscous.update_induced_velocities_at_control_points(
-                &wing_circulation_strength
-            );
+            let frozen_wake = &mut self.wing_corrections[wing_index].as_mut().unwrap().frozen_wake;
 
-            frozen_wake_default.update_induced_velocities_at_control_points(
+            frozen_wake.update_induced_velocities_at_control_points(
                 &wing_circulation_strength
             );
 
             for i in 0..nr_span_lines {
-                u_i_correction.push(
-                    frozen_wake_default.induced_velocities_at_control_points[i] -
-                    frozen_wake_viscous.induced_velocities_at_control_points[i]
-                );
+                velocity[wind_indices.start + i] += 
+                    correction_factor * frozen_wake.induced_velocities_at_control_points[i];
             }
         }
-        
-        if let Some(initialization_time) = self.initialization_time {
-            let correction_factor = cosine_transition_zero_to_one(time, 0.0, initialization_time);
-            
-            for i in 0..u_i_correction.len() {
-                u_i_correction[i] *= correction_factor;
-            }
+    }
+
+    /// Computes the induced velocity factors for a single wing, with the wake in the input 
+    /// direction
+    fn wing_correction(
+        &self, 
+        wing_span_lines: &[SpanLine], 
+        wake_direction: SpatialVector
+    ) -> WingCorrection {
+        let wake_vector = wake_direction * self.wake_length_factor;
+
+        let frozen_wake_viscous = FrozenWake::steady_wake_for_single_wing_from_span_lines_and_direction(
+            wing_span_lines,
+            wake_vector,
+            self.viscous_core_length,
+            self.symmetry_condition
+        );
+
+        let mut frozen_wake = FrozenWake::steady_wake_for_single_wing_from_span_lines_and_direction(
+            wing_span_lines,
+            wake_vector,
+            self.viscous_core_length / 100.0,
+            self.symmetry_condition
+        );
+
+        // The induced velocities are linear in the circulation strength, so the difference 
+        // between the two wakes can be represented with a single set of factors
+        for (factor, factor_viscous) in frozen_wake.variable_velocity_factors.data.iter_mut()
+            .zip(frozen_wake_viscous.variable_velocity_factors.data.iter()) 
+        {
+            *factor -= *factor_viscous;
         }
 
-        u_i_correction
+        WingCorrection {
+            span_lines: wing_span_lines.to_vec(),
+            wake_direction,
+            frozen_wake,
+        }
     }
 }
@@ -6,12 +6,18 @@
 
 use std::fs;
 use std::path::Path;
+use std::ops::Range;
 
 pub mod projection;
 pub mod sampling;
 pub mod builder;
 pub mod solver;
 pub mod corrections;
+pub mod restart;
+pub mod body_frame;
+
+#[cfg(test)]
+mod tests;
 
 use stormath::smoothing::gaussian::gaussian_kernel;
 
@@ -20,15 +26,18 @@ use stormath::type_aliases::Float;
 use crate::line_force_model::LineForceModel;
 
 use crate::common_utils::prelude::*;
+use crate::common_utils::results::result_stream::LazyResultStream;
 use crate::controller::prelude::*;
 use crate::wind::environment::WindEnvironment;
 
 use crate::io_utils;
 
 use projection::ProjectionSettings;
+use projection::fast_exp::{fast_exp, fast_exp_f32};
 use sampling::SamplingSettings;
 use builder::ActuatorLineBuilder;
-use solver::SolverSettings;
+use solver::{SolverSettings, SubStepState, SolverWorkspace, ForceInterpolation};
+use body_frame::BodyFrameReference;
 
 use corrections::{
     lifting_line::LiftingLineCorrection,
@@ -56,6 +65,11 @@ pub struct ActuatorLine {
     pub current_iteration: usize,
     /// The number of iterations between each time a full simulation result is written to file
     pub write_iterations_full_result: usize,
+    /// Switch to write the full simulation result at every iteration to a binary result stream,
+    /// instead of writing JSON files at every `write_iterations_full_result` iteration
+    pub write_binary_results: bool,
+    /// The binary result stream, which is opened at the first write and kept open after that
+    pub result_stream: LazyResultStream,
     /// Vector to store interpolated velocity values for each control point
     pub ctrl_points_velocity: Vec<SpatialVector>,
     /// Results from the model
@@ -68,6 +82,13 @@ pub struct ActuatorLine {
     pub lifting_line_correction: Option<LiftingLineCorrection>,
     /// Empirical correction for the circulation strength, also known as a tip loss factor
     pub empirical_circulation_correction: Option<EmpiricalCirculationCorrection>,
+    /// State used when the model is not solved at every time step
+    pub sub_step_state: SubStepState,
+    /// Buffers that are reused at each solve
+    pub workspace: SolverWorkspace,
+    /// The rigid body motion of the model when the mesh in a CFD solver was last used as a 
+    /// reference for the body frame motion
+    pub body_frame_reference: Option<BodyFrameReference>,
 }
 
 impl ActuatorLine {
@@ -96,15 +117,32 @@ impl ActuatorLine {
         cell_center: SpatialVector,
         cell_volume: Float
     ) -> (SpatialVector, Float) {
+        let denominator = cell_volume * self.velocity_sampling_weight_at_point(
+            line_index, cell_center
+        );
+
+        let numerator = velocity * denominator;
+
+        (numerator, denominator)
+    }
+
+    /// Returns the weight used for a point when the velocity at the control point of a line element
+    /// is estimated using the integral method. The weight only depends on the geometry, so it can
+    /// be computed once for each cell and reused as long as the line elements do not move.
+    pub fn velocity_sampling_weight_at_point(
+        &self,
+        line_index: usize,
+        point: SpatialVector
+    ) -> Float {
         let span_line = self.line_force_model.span_lines_global[line_index];
         let chord_vector = self.line_force_model.chord_vectors_global[line_index];
 
         let projection_value_org = self.projection_settings.projection_value_at_point(
-            cell_center, chord_vector, &span_line
+            point, chord_vector, &span_line
         );
 
-        let projection_value = if projection_value_org > 0.0 {
-            let line_coordinates = span_line.line_coordinates(cell_center, chord_vector);
+        if projection_value_org > 0.0 {
+            let line_coordinates = span_line.line_coordinates(point, chord_vector);
 
             let span_projection = if self.sampling_settings.neglect_span_projection {
                 1.0
@@ -122,42 +160,143 @@ impl ActuatorLine {
             projection_value_org * span_projection
         } else {
             0.0
-        };
-
-        let denominator = cell_volume * projection_value;
-        let numerator = velocity * denominator;
-
-        (numerator, denominator)
+        }
     }
 
 
     /// Function to be executed at each time step in the CFD simulation.
     ///
     /// It solves for the circulation strength and computes the simulation result based on the
-    /// current estimate of the control point velocities.
+    /// current estimate of the control point velocities. If the solver settings specify that the 
+    /// model should not be solved at every time step, the forces to project are instead held or 
+    /// interpolated at the steps in between.
     pub fn do_step(&mut self, time: Float, time_step: Float){
-        if time >= self.start_time {
-            let solver_result = self.solve(time, time_step);
+        let is_solve_step = self.is_solve_step(time, time_step);
 
-            let ctrl_point_acceleration = vec![
-                SpatialVector::default();
-                self.line_force_model.nr_span_lines()
-            ];
+        if is_solve_step {
+            self.solve_step(time, time_step);
+        } else if time >= self.start_time {
+            self.interpolate_sectional_forces_to_project(time, time_step);
+        }
 
-            let simulation_result = self.line_force_model.calculate_simulation_result(
-                &solver_result,
-                &ctrl_point_acceleration,
-                time,
-            );
-            
-            //self.line_force_model.update_flow_derivatives(&result);
+        self.sub_step_state.last_step_time = Some(time);
+        self.sub_step_state.last_step_is_solve_step = is_solve_step;
+
+        self.current_iteration += 1;
+    }
 
-            self.simulation_result = Some(simulation_result);
-            
-            self.update_sectional_forces_to_project();
+    /// Solves the model again for the current time step, without advancing the iteration counter. 
+    /// This is useful when the CFD solver requests the forces several times within the same time 
+    /// step, for instance due to several outer iterations. Nothing is done if the current time 
+    /// step is not a solve step.
+    pub fn repeat_step(&mut self, time: Float, time_step: Float){
+        if self.is_solve_step(time, time_step) {
+            self.solve_step(time, time_step);
         }
+    }
 
-        self.current_iteration += 1;
+    /// Checks if the model should be solved at the input time, based on the solver settings. The
+    /// answer is the same for repeated calls at the same time, also after the step is taken. This
+    /// can be used to skip the velocity sampling at steps where the model is not solved.
+    pub fn is_solve_step(&self, time: Float, time_step: Float) -> bool {
+        if time < self.start_time {
+            return false;
+        }
+
+        let state = &self.sub_step_state;
+
+        if state.last_step_time == Some(time) {
+            return state.last_step_is_solve_step;
+        }
+
+        let Some(last_solve_time) = state.last_solve_time else {
+            return true;
+        };
+
+        if let Some(solve_time_interval) = self.solver_settings.solve_time_interval {
+            // Solve at the time step closest to the end of the interval
+            time - last_solve_time + 0.5 * time_step >= solve_time_interval
+        } else {
+            self.current_iteration - state.last_solve_iteration >= self.solver_settings.solve_interval
+        }
+    }
+
+    /// Solves the model and updates the forces to project
+    fn solve_step(&mut self, time: Float, time_step: Float) {
+        let is_repeated_solve = self.sub_step_state.last_solve_time == Some(time);
+
+        let is_first_solve = self.sub_step_state.last_solve_time.is_none();
+
+        // The interpolation starts from the forces that were projected before this solve
+        if !is_repeated_solve {
+            self.sub_step_state.start_lift_forces.clone_from(&self.sectional_lift_forces_to_project);
+            self.sub_step_state.start_drag_forces.clone_from(&self.sectional_drag_forces_to_project);
+        }
+
+        self.solve_in_place(time);
+
+        let simulation_result = self.line_force_model.calculate_simulation_result(
+            &self.workspace.solver_result,
+            &self.workspace.ctrl_point_acceleration,
+            time,
+        );
+        
+        //self.line_force_model.update_flow_derivatives(&result);
+
+        self.simulation_result = Some(simulation_result);
+        
+        self.update_sectional_forces_to_project();
+
+        let state = &mut self.sub_step_state;
+
+        state.end_lift_forces.clone_from(&self.sectional_lift_forces_to_project);
+        state.end_drag_forces.clone_from(&self.sectional_drag_forces_to_project);
+
+        if is_first_solve {
+            state.start_lift_forces.clone_from(&state.end_lift_forces);
+            state.start_drag_forces.clone_from(&state.end_drag_forces);
+        }
+
+        self.sub_step_state.last_solve_time = Some(time);
+        self.sub_step_state.last_solve_iteration = self.current_iteration;
+
+        self.interpolate_sectional_forces_to_project(time, time_step);
+    }
+
+    /// Sets the forces to project at the input time, based on the forces from the last solve and 
+    /// the force interpolation setting.
+    fn interpolate_sectional_forces_to_project(&mut self, time: Float, time_step: Float) {
+        let state = &self.sub_step_state;
+
+        let Some(last_solve_time) = state.last_solve_time else {
+            return;
+        };
+
+        let factor = match self.solver_settings.force_interpolation {
+            ForceInterpolation::Hold => 1.0,
+            ForceInterpolation::Linear => {
+                let interval = if let Some(solve_time_interval) = self.solver_settings.solve_time_interval {
+                    solve_time_interval
+                } else {
+                    self.solver_settings.solve_interval as Float * time_step
+                };
+
+                // The end value is reached at the last step before the next solve
+                if interval > 0.0 {
+                    ((time - last_solve_time + time_step) / interval).clamp(0.0, 1.0)
+                } else {
+                    1.0
+                }
+            }
+        };
+
+        for line_index in 0..self.line_force_model.nr_span_lines() {
+            self.sectional_lift_forces_to_project[line_index] = state.start_lift_forces[line_index] + 
+                factor * (state.end_lift_forces[line_index] - state.start_lift_forces[line_index]);
+
+            self.sectional_drag_forces_to_project[line_index] = state.start_drag_forces[line_index] +
+                factor * (state.end_drag_forces[line_index] - state.start_drag_forces[line_index]);
+        }
     }
 
     /// Function to update the controller in the model, if the controller is present.
@@ -203,33 +342,53 @@ impl ActuatorLine {
 
     /// Computes a corrected velocity at the control points, based on the sampling settings, and,
     /// if present, the lifting line correction.
-    pub fn corrected_ctrl_points_velocity(&self, time: Float) -> Vec<SpatialVector> {
-        let mut corrected_velocity = if self.sampling_settings.remove_span_velocity {
-            self.line_force_model.remove_span_velocity(
-                &self.ctrl_points_velocity,
-                CoordinateSystem::Global
-            )
+    pub fn corrected_ctrl_points_velocity(&mut self, time: Float) -> Vec<SpatialVector> {
+        let mut corrected_velocity = Vec::new();
+
+        self.set_corrected_ctrl_points_velocity(time, &mut corrected_velocity);
+
+        corrected_velocity
+    }
+
+    /// Same as [ActuatorLine::corrected_ctrl_points_velocity], but the result is written to the 
+    /// input vector, so that the memory can be reused between time steps.
+    pub fn set_corrected_ctrl_points_velocity(
+        &mut self, 
+        time: Float, 
+        corrected_velocity: &mut Vec<SpatialVector>
+    ) {
+        corrected_velocity.clear();
+
+        if self.sampling_settings.remove_span_velocity {
+            let span_lines = &self.line_force_model.span_lines_global;
+
+            corrected_velocity.extend(
+                self.ctrl_points_velocity.iter().zip(span_lines.iter()).map(|(velocity, line)| {
+                    *velocity - velocity.project(line.relative_vector())
+                })
+            );
         } else {
-            self.ctrl_points_velocity.clone()
-        };
+            corrected_velocity.extend_from_slice(&self.ctrl_points_velocity);
+        }
+
+        if let Some(lifting_line_correction) = &mut self.lifting_line_correction {
+            let zero_circulation_strength;
 
-        if let Some(lifting_line_correction) = &self.lifting_line_correction {
             let last_circulation_strength = if let Some(result) = &self.simulation_result {
-                result.force_input.circulation_strength.clone()
+                &result.force_input.circulation_strength
             } else {
-                vec![0.0; self.line_force_model.nr_span_lines()]
+                zero_circulation_strength = vec![0.0; self.line_force_model.nr_span_lines()];
+
+                &zero_circulation_strength
             };
 
-            let ll_velocity_correction = lifting_line_correction.velocity_correction(
+            lifting_line_correction.add_velocity_correction(
                 &self.line_force_model,
                 &self.ctrl_points_velocity,
-                &last_circulation_strength,
-                time - self.start_time
+                last_circulation_strength,
+                time - self.start_time,
+                corrected_velocity
             );
-
-            for i in 0..corrected_velocity.len() {
-                corrected_velocity[i] += ll_velocity_correction[i];
-            }
         }
 
         for i in 0..corrected_velocity.len() {
@@ -261,23 +420,42 @@ impl ActuatorLine {
                     last_delta_velocity;
             }
         }
-
-        corrected_velocity
     }
 
     /// Takes the estimated velocity on at the control points as input and calculates a simulation
     /// result from the line force model.
     pub fn solve(&mut self, time: Float, _time_step: Float) -> SolverResult {
-        let corrected_ctrl_points_velocity = self.corrected_ctrl_points_velocity(time);
+        self.solve_in_place(time);
+
+        self.workspace.solver_result.clone()
+    }
+
+    /// Same as [ActuatorLine::solve], but the result is stored in the workspace of the model, 
+    /// where the vectors from the previous time step are reused.
+    pub fn solve_in_place(&mut self, time: Float) {
+        // The workspace is moved out while it is filled, so that the rest of the model can be 
+        // borrowed at the same time. This does not allocate.
+        let mut workspace = std::mem::take(&mut self.workspace);
+
+        let nr_span_lines = self.line_force_model.nr_span_lines();
+
+        let solver_result = &mut workspace.solver_result;
+
+        self.set_corrected_ctrl_points_velocity(
+            time, 
+            &mut solver_result.output_ctrl_points_velocity
+        );
+
+        let corrected_ctrl_points_velocity = &solver_result.output_ctrl_points_velocity;
 
         let angles_of_attack = self.line_force_model.angles_of_attack(
-            &corrected_ctrl_points_velocity,
+            corrected_ctrl_points_velocity,
             CoordinateSystem::Global
         );
 
         let mut new_estimated_circulation_strength = self.line_force_model.circulation_strength(
             &angles_of_attack,
-            &corrected_ctrl_points_velocity
+            corrected_ctrl_points_velocity
         );
 
         if let Some(empirical_circulation_correction) = &self.empirical_circulation_correction {
@@ -290,38 +468,48 @@ impl ActuatorLine {
             }
         }
 
-        let previous_strength = if let Some(simulation_result) = &self.simulation_result {
-            simulation_result.force_input.circulation_strength.clone()
-        } else {
-            vec![0.0; self.line_force_model.nr_span_lines()]
-        };
+        let circulation_strength = &mut solver_result.circulation_strength;
 
-        let mut circulation_strength = Vec::with_capacity(new_estimated_circulation_strength.len());
-        for i in 0..new_estimated_circulation_strength.len() {
-            let strength_difference = new_estimated_circulation_strength[i] - previous_strength[i];
+        circulation_strength.clear();
 
-            circulation_strength.push(
-                previous_strength[i] + self.solver_settings.damping_factor * strength_difference
+        if let Some(simulation_result) = &self.simulation_result {
+            let previous_strength = &simulation_result.force_input.circulation_strength;
+
+            circulation_strength.extend(
+                new_estimated_circulation_strength.iter().zip(previous_strength.iter()).map(
+                    |(new_strength, previous_strength)| {
+                        previous_strength + 
+                        self.solver_settings.damping_factor * (new_strength - previous_strength)
+                    }
+                )
+            );
+        } else {
+            circulation_strength.extend(
+                new_estimated_circulation_strength.iter().map(
+                    |new_strength| self.solver_settings.damping_factor * new_strength
+                )
             );
         }
 
-        let residual = self.line_force_model.average_residual_absolute(
+        solver_result.residual = self.line_force_model.average_residual_absolute(
             &angles_of_attack,
-            &circulation_strength,
-            &corrected_ctrl_points_velocity
+            &solver_result.circulation_strength,
+            &solver_result.output_ctrl_points_velocity
         );
 
-        SolverResult {
-            input_ctrl_points_velocity: self.ctrl_points_velocity.clone(),
-            circulation_strength,
-            output_ctrl_points_velocity: corrected_ctrl_points_velocity,
-            iterations: 1,
-            residual,
-        }
+        solver_result.input_ctrl_points_velocity.clone_from(&self.ctrl_points_velocity);
+        solver_result.iterations = 1;
+
+        workspace.ctrl_point_acceleration.resize(nr_span_lines, SpatialVector::default());
+
+        self.workspace = workspace;
     }
 
+    /// Name of the binary result stream, relative to the result folder
+    pub const RESULT_STREAM_FILE_NAME: &'static str = "stormbird_results.bin";
+
     /// Writes the resulting values from the line force model to a file.
-    pub fn write_results(&self, folder_path: &str) {
+    pub fn write_results(&mut self, folder_path: &str) {
         if let Some(simulation_result) = &self.simulation_result {
             let overall_folder_path = Path::new(folder_path);
 
@@ -337,7 +525,13 @@ impl ActuatorLine {
                 &data
             );
 
-            if self.current_iteration % self.write_iterations_full_result == 0 {
+            if self.write_binary_results {
+                let result_stream_path = overall_folder_path.join(Self::RESULT_STREAM_FILE_NAME);
+
+                // Flushed at each write, so that the file is complete if the simulation stops
+                self.result_stream.write(&result_stream_path, simulation_result);
+                self.result_stream.flush();
+            } else if self.current_iteration % self.write_iterations_full_result == 0 {
                 let result_folder_path = Path::new(folder_path).join("stormbird_full_results");
                 io_utils::folder_management::ensure_folder_exists(&result_folder_path).unwrap();
 
@@ -453,28 +647,262 @@ impl ActuatorLine {
 
     /// Computes the sum of the projection weights for all line elements at a given point in space.
     pub fn summed_projection_weights_at_point(&self, point: SpatialVector) -> Float {
-        self.line_segments_projection_weights_at_point(point).iter().sum()
+        self.projection_data_at_point(point).0
     }
 
     /// Checks which line element is dominating at a given point in space by comparing the
     /// projection weights of each line element.
     pub fn dominating_line_element_index_at_point(&self, point: SpatialVector) -> usize {
-        let projection_weights = self.line_segments_projection_weights_at_point(point);
+        self.projection_data_at_point(point).1
+    }
+
+    /// Returns an axis aligned bounding box for a line element, which is guaranteed to contain all
+    /// points where the summed projection weight can exceed the input weight limit due to
+    /// contributions from this line element.
+    ///
+    /// The summed weight can only exceed the limit at a point if at least one of the line elements
+    /// contributes more than the limit divided by the number of line elements. The box for each
+    /// line element is therefore computed from this reduced limit, which makes the union of all
+    /// boxes a conservative estimate of the region where the summed weight exceeds the limit.
+    pub fn line_element_bounding_box(
+        &self,
+        line_index: usize,
+        weight_limit: Float
+    ) -> Option<[SpatialVector; 2]> {
+        let nr_span_lines = self.line_force_model.nr_span_lines() as Float;
+
+        self.projection_settings.bounding_box(
+            self.line_force_model.chord_vectors_global[line_index],
+            &self.line_force_model.span_lines_global[line_index],
+            weight_limit / nr_span_lines
+        )
+    }
+
+    /// Returns an axis aligned bounding box for a line element that, like
+    /// [ActuatorLine::line_element_bounding_box], contains all points where the summed projection
+    /// weight can exceed the weight limit due to this line element, but which is valid for any
+    /// local wing angle. This can be used to avoid searching for new cells when a wing rotates.
+    pub fn line_element_swept_bounding_box(
+        &self,
+        line_index: usize,
+        weight_limit: Float
+    ) -> Option<[SpatialVector; 2]> {
+        let nr_span_lines = self.line_force_model.nr_span_lines() as Float;
+
+        let span_line = &self.line_force_model.span_lines_global[line_index];
+
+        let radius = self.projection_settings.bounding_radius(
+            self.line_force_model.chord_vectors_global[line_index],
+            span_line,
+            weight_limit / nr_span_lines
+        )?;
+
+        let extent = SpatialVector::new(radius, radius, radius);
+        let center = span_line.ctrl_point();
 
+        Some([center - extent, center + extent])
+    }
+
+    /// Computes both the summed projection weight and the index of the dominating line element at a
+    /// given point in space. The projection function is only evaluated once for each line element,
+    /// and no temporary storage is allocated, which makes this the preferred method when both
+    /// values are needed, for instance when setting up the projection data in a CFD solver.
+    pub fn projection_data_at_point(&self, point: SpatialVector) -> (Float, usize) {
+        let (summed_weight, _, max_index) = self.projection_data_at_point_for_line_elements(
+            point,
+            0..self.line_force_model.nr_span_lines()
+        );
+
+        (summed_weight, max_index)
+    }
+
+    /// Computes the summed projection weight, the maximum weight and the index of the line element
+    /// with the maximum weight, using only the line elements in the input range. This is useful
+    /// when the projection data is updated for one wing at the time.
+    pub fn projection_data_at_point_for_line_elements(
+        &self,
+        point: SpatialVector,
+        line_indices: Range<usize>
+    ) -> (Float, Float, usize) {
+        let span_lines = &self.line_force_model.span_lines_global;
+        let chord_vectors = &self.line_force_model.chord_vectors_global;
+
+        let mut summed_weight = 0.0;
         let mut max_weight = -1.0;
-        let mut max_index = self.line_force_model.nr_span_lines();
+        let mut max_index = line_indices.end;
 
-        for (i, weight) in projection_weights.iter().enumerate() {
-            if *weight > max_weight {
-                max_weight = *weight;
+        for i in line_indices.clone() {
+            let weight = self.projection_settings.projection_value_at_point(
+                point,
+                chord_vectors[i],
+                &span_lines[i]
+            );
+
+            summed_weight += weight;
+
+            if weight > max_weight {
+                max_weight = weight;
                 max_index = i;
             }
         }
 
-        if max_index == self.line_force_model.nr_span_lines() {
+        if max_index == line_indices.end {
+            panic!("No dominating line element found!");
+        }
+
+        (summed_weight, max_weight, max_index)
+    }
+
+    /// Computes the projection weights from the line element with the input index at a batch of
+    /// points, where the coordinates are given as separate arrays. The points are evaluated 
+    /// several at a time, which makes this much faster than calling 
+    /// [ActuatorLine::line_segments_projection_weights_at_point] for each point.
+    pub fn line_segment_projection_weights_at_points(
+        &self,
+        line_index: usize,
+        x: &[Float],
+        y: &[Float],
+        z: &[Float],
+        weights: &mut [Float]
+    ) {
+        let kernel = self.projection_settings.line_kernel(
+            self.line_force_model.chord_vectors_global[line_index],
+            &self.line_force_model.span_lines_global[line_index]
+        );
+
+        kernel.values_at_points(x, y, z, weights);
+    }
+
+    /// Same as [ActuatorLine::line_segment_projection_weights_at_points], but with the weights 
+    /// evaluated and stored in single precision.
+    pub fn line_segment_projection_weights_at_points_single(
+        &self,
+        line_index: usize,
+        x: &[Float],
+        y: &[Float],
+        z: &[Float],
+        weights: &mut [f32]
+    ) {
+        let kernel = self.projection_settings.line_kernel(
+            self.line_force_model.chord_vectors_global[line_index],
+            &self.line_force_model.span_lines_global[line_index]
+        );
+
+        kernel.values_at_points_single(x, y, z, weights);
+    }
+
+    /// Batch version of [ActuatorLine::projection_data_at_point_for_line_elements], where the
+    /// coordinates of the points are given as separate arrays. The projection function is 
+    /// evaluated for one line element at the time, for all points.
+    pub fn projection_data_at_points_for_line_elements(
+        &self,
+        x: &[Float],
+        y: &[Float],
+        z: &[Float],
+        line_indices: Range<usize>,
+        summed_weights: &mut [Float],
+        max_weights: &mut [Float],
+        max_indices: &mut [usize]
+    ) {
+        let nr_points = summed_weights.len();
+
+        assert_eq!(max_weights.len(), nr_points);
+        assert_eq!(max_indices.len(), nr_points);
+
+        if line_indices.is_empty() {
             panic!("No dominating line element found!");
         }
 
-        max_index
+        summed_weights.fill(0.0);
+        max_weights.fill(-1.0);
+        max_indices.fill(line_indices.start);
+
+        let mut weights: Vec<Float> = vec![0.0; nr_points];
+
+        for line_index in line_indices {
+            self.line_segment_projection_weights_at_points(line_index, x, y, z, &mut weights);
+
+            for i in 0..nr_points {
+                summed_weights[i] += weights[i];
+
+                if weights[i] > max_weights[i] {
+                    max_weights[i] = weights[i];
+                    max_indices[i] = line_index;
+                }
+            }
+        }
+    }
+
+    /// Batch version of [ActuatorLine::velocity_sampling_weight_at_point], for a single line 
+    /// element and with the coordinates of the points given as separate arrays.
+    pub fn velocity_sampling_weights_at_points(
+        &self,
+        line_index: usize,
+        x: &[Float],
+        y: &[Float],
+        z: &[Float],
+        weights: &mut [Float]
+    ) {
+        self.line_segment_projection_weights_at_points(line_index, x, y, z, weights);
+
+        if self.sampling_settings.neglect_span_projection {
+            return;
+        }
+
+        let span_line = self.line_force_model.span_lines_global[line_index];
+
+        let ctrl_point = span_line.ctrl_point();
+        let span_direction = span_line.direction();
+
+        let span_smoothing_length = self.sampling_settings.span_projection_factor * 
+            span_line.length();
+
+        let exponent_factor = -1.0 / (2.0 * span_smoothing_length.powi(2));
+
+        for i in 0..weights.len() {
+            let span = 
+                (x[i] - ctrl_point[0]) * span_direction[0] + 
+                (y[i] - ctrl_point[1]) * span_direction[1] +
+                (z[i] - ctrl_point[2]) * span_direction[2];
+
+            weights[i] *= fast_exp(exponent_factor * span * span);
+        }
+    }
+
+    /// Same as [ActuatorLine::velocity_sampling_weights_at_points], but with the weights 
+    /// evaluated and stored in single precision.
+    pub fn velocity_sampling_weights_at_points_single(
+        &self,
+        line_index: usize,
+        x: &[Float],
+        y: &[Float],
+        z: &[Float],
+        weights: &mut [f32]
+    ) {
+        self.line_segment_projection_weights_at_points_single(line_index, x, y, z, weights);
+
+        if self.sampling_settings.neglect_span_projection {
+            return;
+        }
+
+        let span_line = self.line_force_model.span_lines_global[line_index];
+
+        let ctrl_point = span_line.ctrl_point();
+        let span_direction = span_line.direction();
+
+        let span_smoothing_length = self.sampling_settings.span_projection_factor * 
+            span_line.length();
+
+        let exponent_factor = (-1.0 / (2.0 * span_smoothing_length.powi(2))) as f32;
+
+        for i in 0..weights.len() {
+            let span = (
+                (x[i] - ctrl_point[0]) * span_direction[0] + 
+                (y[i] - ctrl_point[1]) * span_direction[1] +
+                (z[i] - ctrl_point[2]) * span_direction[2]
+            ) as f32;
+
+            weights[i] *= fast_exp_f32(exponent_factor * span * span);
+        }
     }
 }
@@ -0,0 +1,112 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+//! Exponential function without branches or library calls, so that loops over many points can be
+//! vectorised by the compiler. The standard library `exp` is a call into the math library, which
+//! prevents vectorisation of the projection kernels.
+//!
+//! The input is split as `x = k ln(2) + r`, where `k` is an integer and `|r| <= ln(2) / 2`. The
+//! result is then `2^k exp(r)`, where `exp(r)` is given by a Taylor polynomial and `2^k` is
+//! constructed directly from the bits of a floating point number. The relative error is a few
+//! units in the last place compared to [Float::exp]. Inputs below the range of normal numbers are
+//! clamped, which gives values that are negligible compared to any weight limit, rather than zero.
+//!
+//! Both a double and a single precision version are available, independent of the precision of
+//! [Float], so that kernels where single precision is sufficient can use twice as many lanes.
+
+use stormath::type_aliases::Float;
+
+mod double_precision {
+    /// Adding this number to a value of moderate size rounds the value to the nearest integer,
+    /// which is then stored in the lowest bits of the sum
+    pub const ROUND_MAGIC: f64 = 6755399441055744.0; // 1.5 * 2^52
+    pub const MANTISSA_BITS: u32 = 52;
+    pub const EXPONENT_BIAS: u64 = 1023;
+    pub const MIN_INPUT: f64 = -708.0;
+    pub const MAX_INPUT: f64 = 709.0;
+    pub const LN2_HI: f64 = 6.93147180369123816490e-01;
+    pub const LN2_LO: f64 = 1.90821492927058770002e-10;
+    /// The Taylor coefficients 1/n!, from the highest order to the lowest
+    pub const COEFFICIENTS: [f64; 13] = [
+        1.0 / 479001600.0,
+        1.0 / 39916800.0,
+        1.0 / 3628800.0,
+        1.0 / 362880.0,
+        1.0 / 40320.0,
+        1.0 / 5040.0,
+        1.0 / 720.0,
+        1.0 / 120.0,
+        1.0 / 24.0,
+        1.0 / 6.0,
+        0.5,
+        1.0,
+        1.0,
+    ];
+}
+
+mod single_precision {
+    pub const ROUND_MAGIC: f32 = 12582912.0; // 1.5 * 2^23
+    pub const MANTISSA_BITS: u32 = 23;
+    pub const EXPONENT_BIAS: u32 = 127;
+    pub const MIN_INPUT: f32 = -87.0;
+    pub const MAX_INPUT: f32 = 88.0;
+    pub const LN2_HI: f32 = 0.693359375;
+    pub const LN2_LO: f32 = -2.12194440e-4;
+    pub const COEFFICIENTS: [f32; 8] = [
+        1.0 / 5040.0,
+        1.0 / 720.0,
+        1.0 / 120.0,
+        1.0 / 24.0,
+        1.0 / 6.0,
+        0.5,
+        1.0,
+        1.0,
+    ];
+}
+
+/// Implements the exponential function for one floating point type, with the constants from the
+/// input module
+macro_rules! fast_exp_implementation {
+    ($name:ident, $float:ty, $constants:ident) => {
+        #[inline(always)]
+        /// Computes the exponential of the input value. See the module documentation for details.
+        pub fn $name(x: $float) -> $float {
+            use $constants::*;
+
+            let x = x.max(MIN_INPUT).min(MAX_INPUT);
+
+            let shifted = x * std::f64::consts::LOG2_E as $float + ROUND_MAGIC;
+            let k = shifted - ROUND_MAGIC;
+
+            let r = (x - k * LN2_HI) - k * LN2_LO;
+
+            let mut exp_r = COEFFICIENTS[0];
+
+            for coefficient in COEFFICIENTS.iter().skip(1) {
+                exp_r = exp_r * r + coefficient;
+            }
+
+            // The lowest bits of the shifted value contain k as a two's complement integer. 
+            // Adding the bias and shifting it into the exponent field gives 2^k.
+            let scale = <$float>::from_bits(
+                shifted.to_bits().wrapping_add(EXPONENT_BIAS) << MANTISSA_BITS
+            );
+
+            exp_r * scale
+        }
+    };
+}
+
+fast_exp_implementation!(fast_exp_f64, f64, double_precision);
+fast_exp_implementation!(fast_exp_f32, f32, single_precision);
+
+#[inline(always)]
+/// Computes the exponential of the input value, in the precision of [Float]
+pub fn fast_exp(x: Float) -> Float {
+    #[cfg(not(feature = "single_precision"))]
+    return fast_exp_f64(x);
+
+    #[cfg(feature = "single_precision")]
+    return fast_exp_f32(x);
+}
@@ -11,6 +11,15 @@ use stormath::consts::PI;
 
 use crate::line_force_model::span_line::SpanLine;
 
+use super::fast_exp::{fast_exp, fast_exp_f32};
+
+/// Number of points that are evaluated together in the batch kernels. The loops over each block 
+/// have a fixed length and no branches, so that the compiler can map them to SIMD instructions.
+pub const LANES: usize = 8;
+/// Number of points that are evaluated together in the single precision batch kernels, where 
+/// each SIMD register holds twice as many values
+pub const SINGLE_PRECISION_LANES: usize = 2 * LANES;
+
 #[derive(Debug, Clone, Serialize, Deserialize)]
 #[serde(deny_unknown_fields)]
 pub struct Gaussian {
@@ -59,4 +68,275 @@ impl Gaussian {
 
         (1.0 / const_denominator ) * exp_factor.exp() * span_factor
     }
+
+    /// Precomputes the geometry of the input line segment, so that the projection value can be
+    /// evaluated for many points with [GaussianLineKernel::values_at_points].
+    pub fn line_kernel(&self, chord_vector: SpatialVector, span_line: &SpanLine) -> GaussianLineKernel {
+        let chord_length = chord_vector.length();
+        let line_length = span_line.length();
+
+        let e_chord     = self.chord_factor * chord_length;
+        let e_thickness = self.thickness_factor * chord_length;
+
+        let span_direction      = span_line.relative_vector().normalize();
+        let chord_direction     = chord_vector.normalize();
+        let thickness_direction = span_direction.cross(chord_direction);
+
+        GaussianLineKernel {
+            ctrl_point: span_line.ctrl_point(),
+            scaled_chord_direction: chord_direction / e_chord,
+            scaled_thickness_direction: thickness_direction / e_thickness,
+            scaled_span_direction: span_direction / line_length,
+            amplitude: 1.0 / (e_chord * e_thickness * PI * line_length),
+        }
+    }
+
+    /// Returns the corners of an axis aligned bounding box that contains all points where the 
+    /// projection value is larger than the input weight limit. If the projection value is below the
+    /// limit everywhere, `None` is returned.
+    pub fn bounding_box(
+        &self,
+        chord_vector: SpatialVector,
+        span_line: &SpanLine,
+        weight_limit: Float
+    ) -> Option<[SpatialVector; 2]> {
+        let corner_vectors = self.support_corner_vectors(chord_vector, span_line, weight_limit)?;
+
+        let mut extent = SpatialVector::default();
+
+        for i in 0..3 {
+            for k in 0..3 {
+                extent[k] += corner_vectors[i][k].abs();
+            }
+        }
+
+        let center = span_line.ctrl_point();
+
+        Some([center - extent, center + extent])
+    }
+
+    /// Returns the radius of a sphere around the control point of the span line that contains all
+    /// points where the projection value is larger than the input weight limit. Unlike the 
+    /// bounding box, the sphere is independent of the orientation of the chord vector, which means 
+    /// that it remains valid when a wing is rotated.
+    pub fn bounding_radius(
+        &self,
+        chord_vector: SpatialVector,
+        span_line: &SpanLine,
+        weight_limit: Float
+    ) -> Option<Float> {
+        let [a, b, c] = self.support_corner_vectors(chord_vector, span_line, weight_limit)?;
+
+        let corner_distances = [
+            (a + b + c).length(),
+            (a + b - c).length(),
+            (a - b + c).length(),
+            (a - b - c).length(),
+        ];
+
+        Some(corner_distances.iter().fold(0.0, |max: Float, d| max.max(*d)))
+    }
+
+    /// Computes vectors from the control point of the span line to the faces of the region where
+    /// the projection value is larger than the weight limit. The region is bounded by planes in the
+    /// line coordinate system; the span direction is limited by the end points of the line, while
+    /// the chord and thickness directions are limited by the distance where the exponential term
+    /// drops below the limit. The corners of the region are given by the sum of the three vectors
+    /// with all combinations of signs.
+    fn support_corner_vectors(
+        &self,
+        chord_vector: SpatialVector,
+        span_line: &SpanLine,
+        weight_limit: Float
+    ) -> Option<[SpatialVector; 3]> {
+        let chord_length = chord_vector.length();
+        let line_length = span_line.length();
+
+        let e_chord     = self.chord_factor * chord_length;
+        let e_thickness = self.thickness_factor * chord_length;
+
+        let max_value = 1.0 / (e_chord * e_thickness * PI * line_length);
+
+        if max_value <= weight_limit {
+            return None;
+        }
+
+        let radius_factor = (max_value / weight_limit).ln().sqrt();
+
+        let half_widths = [
+            0.5 * line_length,
+            radius_factor * e_chord,
+            radius_factor * e_thickness
+        ];
+
+        let span_direction      = span_line.relative_vector().normalize();
+        let chord_direction     = chord_vector.normalize();
+        let thickness_direction = span_direction.cross(chord_direction);
+
+        // The dual basis of the line coordinate directions also handles chord vectors that are not
+        // normal to the span line.
+        let determinant = span_direction.dot(chord_direction.cross(thickness_direction));
+
+        Some([
+            chord_direction.cross(thickness_direction) * (half_widths[0] / determinant),
+            thickness_direction.cross(span_direction) * (half_widths[1] / determinant),
+            span_direction.cross(chord_direction) * (half_widths[2] / determinant),
+        ])
+    }
+}
+
+#[derive(Debug, Clone)]
+/// The Gaussian projection function for a single line segment, with the geometry stored in the 
+/// form that is needed to evaluate it. The directions are divided by the smoothing lengths and the 
+/// line length, so that each point only needs three dot products and one exponential.
+pub struct GaussianLineKernel {
+    ctrl_point: SpatialVector,
+    scaled_chord_direction: SpatialVector,
+    scaled_thickness_direction: SpatialVector,
+    scaled_span_direction: SpatialVector,
+    amplitude: Float,
+}
+
+impl GaussianLineKernel {
+    /// Computes the projection value at a batch of points, where the coordinates are given as
+    /// separate arrays. Gives the same values as [Gaussian::projection_value_at_point], apart from
+    /// rounding errors.
+    pub fn values_at_points(&self, x: &[Float], y: &[Float], z: &[Float], values: &mut [Float]) {
+        let nr_points = values.len();
+
+        assert_eq!(x.len(), nr_points);
+        assert_eq!(y.len(), nr_points);
+        assert_eq!(z.len(), nr_points);
+
+        let nr_full_blocks = nr_points / LANES;
+
+        for block in 0..nr_full_blocks {
+            let range = block * LANES..(block + 1) * LANES;
+
+            let x_block: &[Float; LANES] = x[range.clone()].try_into().unwrap();
+            let y_block: &[Float; LANES] = y[range.clone()].try_into().unwrap();
+            let z_block: &[Float; LANES] = z[range.clone()].try_into().unwrap();
+            let value_block: &mut [Float; LANES] = (&mut values[range]).try_into().unwrap();
+
+            for lane in 0..LANES {
+                value_block[lane] = self.value(x_block[lane], y_block[lane], z_block[lane]);
+            }
+        }
+
+        for i in nr_full_blocks * LANES..nr_points {
+            values[i] = self.value(x[i], y[i], z[i]);
+        }
+    }
+
+    /// Same as [GaussianLineKernel::values_at_points], but the kernel is evaluated in single 
+    /// precision. Only the offset from the control point is computed in the precision of the 
+    /// coordinates, so that the accuracy does not depend on the distance from the origin. The 
+    /// relative error in the values is then close to the single precision epsilon.
+    pub fn values_at_points_single(
+        &self, 
+        x: &[Float], 
+        y: &[Float], 
+        z: &[Float], 
+        values: &mut [f32]
+    ) {
+        let nr_points = values.len();
+
+        assert_eq!(x.len(), nr_points);
+        assert_eq!(y.len(), nr_points);
+        assert_eq!(z.len(), nr_points);
+
+        let kernel = SinglePrecisionLineKernel::new(self);
+
+        let nr_full_blocks = nr_points / SINGLE_PRECISION_LANES;
+
+        for block in 0..nr_full_blocks {
+            let range = block * SINGLE_PRECISION_LANES..(block + 1) * SINGLE_PRECISION_LANES;
+
+            let x_block: &[Float; SINGLE_PRECISION_LANES] = x[range.clone()].try_into().unwrap();
+            let y_block: &[Float; SINGLE_PRECISION_LANES] = y[range.clone()].try_into().unwrap();
+            let z_block: &[Float; SINGLE_PRECISION_LANES] = z[range.clone()].try_into().unwrap();
+            let value_block: &mut [f32; SINGLE_PRECISION_LANES] = 
+                (&mut values[range]).try_into().unwrap();
+
+            for lane in 0..SINGLE_PRECISION_LANES {
+                value_block[lane] = kernel.value(x_block[lane], y_block[lane], z_block[lane]);
+            }
+        }
+
+        for i in nr_full_blocks * SINGLE_PRECISION_LANES..nr_points {
+            values[i] = kernel.value(x[i], y[i], z[i]);
+        }
+    }
+
+    #[inline(always)]
+    fn value(&self, x: Float, y: Float, z: Float) -> Float {
+        let dx = x - self.ctrl_point[0];
+        let dy = y - self.ctrl_point[1];
+        let dz = z - self.ctrl_point[2];
+
+        let chord = 
+            dx * self.scaled_chord_direction[0] + 
+            dy * self.scaled_chord_direction[1] + 
+            dz * self.scaled_chord_direction[2];
+        let thickness = 
+            dx * self.scaled_thickness_direction[0] + 
+            dy * self.scaled_thickness_direction[1] + 
+            dz * self.scaled_thickness_direction[2];
+        let relative_span = 
+            dx * self.scaled_span_direction[0] + 
+            dy * self.scaled_span_direction[1] + 
+            dz * self.scaled_span_direction[2];
+
+        // The span window as a factor of zero or one, rather than as a branch
+        let inside_span = ((relative_span > -0.5) & (relative_span <= 0.5)) as u8 as Float;
+
+        self.amplitude * inside_span * fast_exp(-chord * chord - thickness * thickness)
+    }
+}
+
+/// The geometry of a [GaussianLineKernel] in single precision, except for the control point
+struct SinglePrecisionLineKernel {
+    ctrl_point: SpatialVector,
+    scaled_chord_direction: [f32; 3],
+    scaled_thickness_direction: [f32; 3],
+    scaled_span_direction: [f32; 3],
+    amplitude: f32,
+}
+
+impl SinglePrecisionLineKernel {
+    fn new(kernel: &GaussianLineKernel) -> Self {
+        let single = |vector: SpatialVector| [vector[0] as f32, vector[1] as f32, vector[2] as f32];
+
+        Self {
+            ctrl_point: kernel.ctrl_point,
+            scaled_chord_direction: single(kernel.scaled_chord_direction),
+            scaled_thickness_direction: single(kernel.scaled_thickness_direction),
+            scaled_span_direction: single(kernel.scaled_span_direction),
+            amplitude: kernel.amplitude as f32,
+        }
+    }
+
+    #[inline(always)]
+    fn value(&self, x: Float, y: Float, z: Float) -> f32 {
+        let dx = (x - self.ctrl_point[0]) as f32;
+        let dy = (y - self.ctrl_point[1]) as f32;
+        let dz = (z - self.ctrl_point[2]) as f32;
+
+        let chord = 
+            dx * self.scaled_chord_direction[0] + 
+            dy * self.scaled_chord_direction[1] + 
+            dz * self.scaled_chord_direction[2];
+        let thickness = 
+            dx * self.scaled_thickness_direction[0] + 
+            dy * self.scaled_thickness_direction[1] + 
+            dz * self.scaled_thickness_direction[2];
+        let relative_span = 
+            dx * self.scaled_span_direction[0] + 
+            dy * self.scaled_span_direction[1] + 
+            dz * self.scaled_span_direction[2];
+
+        let inside_span = ((relative_span > -0.5) & (relative_span <= 0.5)) as u8 as f32;
+
+        self.amplitude * inside_span * fast_exp_f32(-chord * chord - thickness * thickness)
+    }
 }
@@ -9,8 +9,9 @@ use stormath::type_aliases::Float;
 use crate::line_force_model::span_line::SpanLine;
 
 pub mod gaussian;
+pub mod fast_exp;
 
-use gaussian::Gaussian;
+use gaussian::{Gaussian, GaussianLineKernel};
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
 #[serde(deny_unknown_fields)]
@@ -25,6 +26,10 @@ pub struct ProjectionSettings {
     pub weight_limit: Float,
     #[serde(default)]
     pub project_sectional_drag: bool,
+    /// If true, the force in a cell is computed as a weighted sum of the forces from all line
+    /// elements that contribute to the cell, rather than using only the dominating line element.
+    #[serde(default)]
+    pub blend_line_elements: bool,
 }
 
 impl Default for ProjectionSettings {
@@ -36,6 +41,7 @@ impl Default for ProjectionSettings {
             realign_to_local_velocity_at_each_cell: false,
             weight_limit: Self::default_weight_limit(),
             project_sectional_drag: false,
+            blend_line_elements: false,
         }
     }
 }
@@ -55,4 +61,36 @@ impl ProjectionSettings {
             point, chord_vector, span_line
         )
     }
-}
\ No newline at end of file
+
+    /// Returns the projection function for the input line segment, for evaluation at many points
+    pub fn line_kernel(&self, chord_vector: SpatialVector, span_line: &SpanLine) -> GaussianLineKernel {
+        self.projection_function.line_kernel(chord_vector, span_line)
+    }
+
+    /// Returns an axis aligned bounding box that contains all points where the projection value
+    /// from the input line segment is larger than the weight limit.
+    pub fn bounding_box(
+        &self,
+        chord_vector: SpatialVector,
+        span_line: &SpanLine,
+        weight_limit: Float
+    ) -> Option<[SpatialVector; 2]> {
+        self.projection_function.bounding_box(
+            chord_vector, span_line, weight_limit
+        )
+    }
+
+    /// Returns the radius of a sphere around the control point of the input line segment that 
+    /// contains all points where the projection value is larger than the weight limit, for any
+    /// orientation of the chord vector.
+    pub fn bounding_radius(
+        &self,
+        chord_vector: SpatialVector,
+        span_line: &SpanLine,
+        weight_limit: Float
+    ) -> Option<Float> {
+        self.projection_function.bounding_radius(
+            chord_vector, span_line, weight_limit
+        )
+    }
+}
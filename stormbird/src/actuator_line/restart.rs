@@ -0,0 +1,160 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+//! Functionality for storing the state of an actuator line model, so that a CFD simulation can be
+//! restarted without starting the model from zero.
+
+use std::fs;
+use std::path::Path;
+
+use serde::{Serialize, Deserialize};
+
+use stormath::spatial_vector::SpatialVector;
+use stormath::type_aliases::Float;
+use stormath::rigid_body_motion::RigidBodyMotion;
+
+use crate::common_utils::prelude::SimulationResult;
+
+use super::ActuatorLine;
+use super::solver::SubStepState;
+
+#[derive(Debug, Clone, Serialize, Deserialize)]
+/// The part of an actuator line model that changes during a simulation. Everything else is given
+/// by the input file, which is read again at a restart.
+pub struct RestartState {
+    pub current_iteration: usize,
+    pub local_wing_angles: Vec<Float>,
+    /// The last results, which contains the circulation strength used as the starting point for 
+    /// the next solve
+    pub simulation_result: Option<SimulationResult>,
+    pub sectional_lift_forces_to_project: Vec<SpatialVector>,
+    pub sectional_drag_forces_to_project: Vec<SpatialVector>,
+    pub sub_step_state: SubStepState,
+    /// The motion of the model, which is set by the CFD solver when the model moves with the mesh.
+    /// Optional, so that states written before the motion was stored can still be used.
+    #[serde(default)]
+    pub rigid_body_motion: Option<RigidBodyMotion>,
+}
+
+impl ActuatorLine {
+    pub fn restart_state(&self) -> RestartState {
+        RestartState {
+            current_iteration: self.current_iteration,
+            local_wing_angles: self.line_force_model.local_wing_angles.clone(),
+            simulation_result: self.simulation_result.clone(),
+            sectional_lift_forces_to_project: self.sectional_lift_forces_to_project.clone(),
+            sectional_drag_forces_to_project: self.sectional_drag_forces_to_project.clone(),
+            sub_step_state: self.sub_step_state.clone(),
+            rigid_body_motion: Some(self.line_force_model.rigid_body_motion.clone()),
+        }
+    }
+
+    /// Sets the state of the model from a restart state. Returns an error, and leaves the model 
+    /// unchanged, if the state does not fit the number of wings and line elements in the model.
+    pub fn apply_restart_state(&mut self, state: RestartState) -> Result<(), String> {
+        let nr_wings = self.line_force_model.nr_wings();
+        let nr_span_lines = self.line_force_model.nr_span_lines();
+
+        if state.local_wing_angles.len() != nr_wings {
+            return Err(format!(
+                "The restart state has {} wings, but the model has {}", 
+                state.local_wing_angles.len(), nr_wings
+            ));
+        }
+
+        if state.sectional_lift_forces_to_project.len() != nr_span_lines {
+            return Err(format!(
+                "The restart state has {} line elements, but the model has {}",
+                state.sectional_lift_forces_to_project.len(), nr_span_lines
+            ));
+        }
+
+        self.current_iteration = state.current_iteration;
+        self.line_force_model.local_wing_angles = state.local_wing_angles;
+        self.simulation_result = state.simulation_result;
+        self.sectional_lift_forces_to_project = state.sectional_lift_forces_to_project;
+        self.sectional_drag_forces_to_project = state.sectional_drag_forces_to_project;
+        self.sub_step_state = state.sub_step_state;
+
+        if let Some(rigid_body_motion) = state.rigid_body_motion {
+            self.line_force_model.rigid_body_motion = rigid_body_motion;
+        }
+
+        self.line_force_model.update_global_data_representations();
+
+        Ok(())
+    }
+
+    pub fn write_restart_state<P: AsRef<Path>>(&self, file_path: P) {
+        let json_string = serde_json::to_string(&self.restart_state()).unwrap();
+
+        if let Some(folder_path) = file_path.as_ref().parent() {
+            fs::create_dir_all(folder_path).unwrap();
+        }
+
+        fs::write(file_path, json_string).unwrap();
+    }
+
+    /// Reads and applies a restart state from file. Returns an error if the file could not be read
+    /// or does not fit the model.
+    pub fn read_restart_state<P: AsRef<Path>>(&mut self, file_path: P) -> Result<(), String> {
+        let json_string = fs::read_to_string(file_path).map_err(|error| error.to_string())?;
+
+        let state: RestartState = serde_json::from_str(&json_string)
+            .map_err(|error| error.to_string())?;
+
+        self.apply_restart_state(state)
+    }
+
+    /// Returns a hash of everything that determines the projection and sampling weights in a CFD
+    /// solver: the global geometry of the line elements, and the projection and sampling 
+    /// settings. Data that is derived from the weights can be reused as long as the hash is 
+    /// unchanged. The hash is computed with a fixed algorithm, so that it can be compared between
+    /// different runs and builds.
+    pub fn geometry_hash(&self) -> u64 {
+        let mut hasher = Fnv1aHasher::default();
+
+        for span_line in &self.line_force_model.span_lines_global {
+            hasher.add_vector(span_line.start_point);
+            hasher.add_vector(span_line.end_point);
+        }
+
+        for chord_vector in &self.line_force_model.chord_vectors_global {
+            hasher.add_vector(*chord_vector);
+        }
+
+        hasher.add_bytes(serde_json::to_string(&self.projection_settings).unwrap().as_bytes());
+        hasher.add_bytes(serde_json::to_string(&self.sampling_settings).unwrap().as_bytes());
+
+        hasher.value
+    }
+}
+
+/// The 64 bit FNV-1a hash function
+struct Fnv1aHasher {
+    value: u64,
+}
+
+impl Default for Fnv1aHasher {
+    fn default() -> Self {
+        Self {
+            value: 0xcbf29ce484222325
+        }
+    }
+}
+
+impl Fnv1aHasher {
+    fn add_bytes(&mut self, bytes: &[u8]) {
+        for byte in bytes {
+            self.value ^= *byte as u64;
+            self.value = self.value.wrapping_mul(0x100000001b3);
+        }
+    }
+
+    fn add_vector(&mut self, vector: SpatialVector) {
+        for i in 0..3 {
+            self.add_bytes(&vector[i].to_le_bytes());
+        }
+    }
+}
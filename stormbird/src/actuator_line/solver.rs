@@ -5,23 +5,82 @@
 
 use serde::{Serialize, Deserialize};
 
+use stormath::spatial_vector::SpatialVector;
 use stormath::type_aliases::Float;
 
+use crate::common_utils::results::solver::SolverResult;
+
+#[derive(Debug, Clone, Copy, Default, PartialEq, Serialize, Deserialize)]
+/// How the projected forces are computed for the time steps where the model is not solved.
+pub enum ForceInterpolation {
+    #[default]
+    /// The forces from the last solve are used directly
+    Hold,
+    /// The forces change linearly from the previously projected forces to the forces from the 
+    /// last solve, over the interval until the next solve. This gives continuous forces, but with 
+    /// a delay of up to one solve interval.
+    Linear,
+}
+
 #[derive(Debug, Clone, Serialize, Deserialize)]
 #[serde(deny_unknown_fields)]
 pub struct SolverSettings {
     #[serde(default="SolverSettings::default_damping_factor")]
     pub damping_factor: Float,
+    #[serde(default="SolverSettings::default_solve_interval")]
+    /// The number of time steps between each time the model is solved. 
+    pub solve_interval: usize,
+    #[serde(default)]
+    /// Optional time interval between each time the model is solved. Overrides the solve interval
+    /// when set.
+    pub solve_time_interval: Option<Float>,
+    #[serde(default)]
+    /// How the forces are computed between each solve
+    pub force_interpolation: ForceInterpolation,
 }
 
 impl Default for SolverSettings {
     fn default() -> Self {
         Self {
             damping_factor: Self::default_damping_factor(),
+            solve_interval: Self::default_solve_interval(),
+            solve_time_interval: None,
+            force_interpolation: ForceInterpolation::default(),
         }
     }
 }
 
 impl SolverSettings {
     fn default_damping_factor() -> Float {0.1}
+    fn default_solve_interval() -> usize {1}
+}
+
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
+/// Data used to determine which time steps to solve the model at, and to interpolate the projected
+/// forces between each solve.
+pub struct SubStepState {
+    /// The time and iteration of the last solve
+    pub last_solve_time: Option<Float>,
+    pub last_solve_iteration: usize,
+    /// The time of the last step, and whether the model was solved at that step. Used to give the
+    /// same answer for repeated steps at the same time.
+    pub last_step_time: Option<Float>,
+    pub last_step_is_solve_step: bool,
+    /// The projected forces at the start of the current interpolation interval
+    pub start_lift_forces: Vec<SpatialVector>,
+    pub start_drag_forces: Vec<SpatialVector>,
+    /// The forces from the last solve
+    pub end_lift_forces: Vec<SpatialVector>,
+    pub end_drag_forces: Vec<SpatialVector>,
+}
+
+#[derive(Debug, Clone, Default)]
+/// Buffers that are reused between the time steps, so that solving the model does not allocate new
+/// vectors for the intermediate values. The content is only valid directly after a solve.
+pub struct SolverWorkspace {
+    /// The result of the last solve, where the output velocity is the corrected control point 
+    /// velocity
+    pub solver_result: SolverResult,
+    /// The acceleration of the control points, which is always zero in the actuator line model
+    pub ctrl_point_acceleration: Vec<SpatialVector>,
 }
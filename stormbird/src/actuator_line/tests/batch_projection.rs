@@ -0,0 +1,215 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+use crate::actuator_line::builder::ActuatorLineBuilder;
+use crate::actuator_line::projection::fast_exp::{fast_exp, fast_exp_f32};
+use crate::actuator_line::projection::gaussian::{Gaussian, LANES, SINGLE_PRECISION_LANES};
+use crate::line_force_model::span_line::SpanLine;
+
+use super::get_wing_model_builder;
+
+use stormath::spatial_vector::SpatialVector;
+use stormath::type_aliases::Float;
+
+/// Points in a box around the input center, stored as separate arrays for each coordinate. The
+/// number of points is not a multiple of the number of lanes, so that the remainder loop is tested.
+fn points_around(center: SpatialVector, size: Float) -> [Vec<Float>; 3] {
+    let nr_points = 13;
+
+    let mut points = [Vec::new(), Vec::new(), Vec::new()];
+
+    for i in 0..nr_points {
+        for j in 0..nr_points {
+            for k in 0..nr_points {
+                let relative_position = SpatialVector::new(
+                    i as Float / (nr_points - 1) as Float - 0.5,
+                    j as Float / (nr_points - 1) as Float - 0.5,
+                    k as Float / (nr_points - 1) as Float - 0.5,
+                ) * size;
+
+                let point = center + relative_position;
+
+                for d in 0..3 {
+                    points[d].push(point[d]);
+                }
+            }
+        }
+    }
+
+    assert_ne!(points[0].len() % LANES, 0);
+    assert_ne!(points[0].len() % SINGLE_PRECISION_LANES, 0);
+
+    points
+}
+
+fn assert_relative_eq(value: Float, reference: Float, tolerance: Float) {
+    let error = (value - reference).abs();
+
+    assert!(
+        error <= tolerance * reference.abs() + Float::MIN_POSITIVE,
+        "Value {} differs from reference {}", value, reference
+    );
+}
+
+#[test]
+fn fast_exp_matches_exp() {
+    let nr_values = 10001;
+
+    // The range of inputs that give normal numbers
+    let min_x = Float::MIN_POSITIVE.ln() + 1.0;
+    let max_x = 40.0;
+
+    for i in 0..nr_values {
+        let x = min_x + (max_x - min_x) * i as Float / (nr_values - 1) as Float;
+
+        assert_relative_eq(fast_exp(x), x.exp(), 10.0 * Float::EPSILON);
+    }
+
+    assert_eq!(fast_exp(0.0), 1.0);
+    assert!(fast_exp(-1.0e6) >= 0.0);
+}
+
+#[test]
+fn single_precision_fast_exp_matches_exp() {
+    let nr_values = 10001;
+
+    let min_x = f32::MIN_POSITIVE.ln() + 1.0;
+    let max_x = 40.0;
+
+    for i in 0..nr_values {
+        let x = min_x + (max_x - min_x) * i as f32 / (nr_values - 1) as f32;
+
+        let error = (fast_exp_f32(x) - x.exp()).abs();
+
+        assert!(
+            error <= 10.0 * f32::EPSILON * x.exp(),
+            "Value {} differs from reference {}", fast_exp_f32(x), x.exp()
+        );
+    }
+
+    assert_eq!(fast_exp_f32(0.0), 1.0);
+    assert!(fast_exp_f32(-1.0e6) >= 0.0);
+}
+
+#[test]
+fn batch_kernel_matches_point_values() {
+    let gaussian = Gaussian::default();
+
+    let span_line = SpanLine {
+        start_point: SpatialVector::new(0.0, 0.0, 0.0),
+        end_point: SpatialVector::new(0.1, 0.05, 0.5),
+    };
+
+    let chord_vector = SpatialVector::new(1.0, 0.2, 0.1);
+
+    let [x, y, z] = points_around(span_line.ctrl_point(), 2.0);
+
+    let mut values = vec![0.0; x.len()];
+
+    gaussian.line_kernel(chord_vector, &span_line).values_at_points(&x, &y, &z, &mut values);
+
+    let mut nr_non_zero = 0;
+
+    for i in 0..x.len() {
+        let point = SpatialVector::new(x[i], y[i], z[i]);
+
+        let reference = gaussian.projection_value_at_point(point, chord_vector, &span_line);
+
+        // Points exactly at the end of the span window may end up on different sides, due to the 
+        // different order of the operations
+        let relative_span = (point - span_line.ctrl_point()).dot(span_line.direction()) / 
+            span_line.length();
+
+        if (relative_span.abs() - 0.5).abs() < 1.0e-6 {
+            continue;
+        }
+        
+        assert_relative_eq(values[i], reference, 1000.0 * Float::EPSILON);
+
+        if reference > 0.0 {
+            nr_non_zero += 1;
+        }
+    }
+
+    assert!(nr_non_zero > 0);
+}
+
+#[test]
+fn batch_sampling_weights_match_point_weights() {
+    let actuator_line = ActuatorLineBuilder::new(get_wing_model_builder()).build();
+
+    let line_index = 2;
+
+    let span_line = actuator_line.line_force_model.span_lines_global[line_index];
+
+    let [x, y, z] = points_around(span_line.ctrl_point(), 1.0);
+
+    let mut weights = vec![0.0; x.len()];
+
+    actuator_line.velocity_sampling_weights_at_points(line_index, &x, &y, &z, &mut weights);
+
+    for i in 0..x.len() {
+        let point = SpatialVector::new(x[i], y[i], z[i]);
+
+        let reference = actuator_line.velocity_sampling_weight_at_point(line_index, point);
+
+        let relative_span = (point - span_line.ctrl_point()).dot(span_line.direction()) / 
+            span_line.length();
+
+        if (relative_span.abs() - 0.5).abs() < 1.0e-6 {
+            continue;
+        }
+
+        assert_relative_eq(weights[i], reference, 1000.0 * Float::EPSILON);
+    }
+}
+
+#[test]
+/// The single precision weights should match the double precision weights to a precision that is
+/// negligible compared to the smoothing, also when the model is far from the origin.
+fn single_precision_sampling_weights_match_double_precision() {
+    let mut actuator_line = ActuatorLineBuilder::new(get_wing_model_builder()).build();
+
+    let offset = SpatialVector::new(1000.0, -500.0, 200.0);
+
+    actuator_line.line_force_model.set_translation_and_rotation_with_finite_difference_for_the_velocity(
+        1.0, offset, SpatialVector::default()
+    );
+
+    let line_index = 2;
+
+    let span_line = actuator_line.line_force_model.span_lines_global[line_index];
+
+    let [x, y, z] = points_around(span_line.ctrl_point(), 1.0);
+
+    let mut weights = vec![0.0; x.len()];
+    let mut single_weights = vec![0.0f32; x.len()];
+
+    actuator_line.velocity_sampling_weights_at_points(line_index, &x, &y, &z, &mut weights);
+    actuator_line.velocity_sampling_weights_at_points_single(
+        line_index, &x, &y, &z, &mut single_weights
+    );
+
+    let max_weight = weights.iter().cloned().fold(0.0, Float::max);
+
+    assert!(max_weight > 0.0);
+
+    for i in 0..x.len() {
+        let point = SpatialVector::new(x[i], y[i], z[i]);
+
+        let relative_span = (point - span_line.ctrl_point()).dot(span_line.direction()) / 
+            span_line.length();
+
+        if (relative_span.abs() - 0.5).abs() < 1.0e-4 {
+            continue;
+        }
+
+        let error = (single_weights[i] as Float - weights[i]).abs();
+
+        assert!(
+            error <= 1.0e-4 * weights[i] + 1.0e-6 * max_weight,
+            "Single precision weight {} differs from reference {}", single_weights[i], weights[i]
+        );
+    }
+}
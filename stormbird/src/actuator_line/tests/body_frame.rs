@@ -0,0 +1,91 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+use crate::actuator_line::builder::ActuatorLineBuilder;
+use crate::actuator_line::body_frame::rotation_from_matrix;
+
+use super::get_wing_model_builder;
+
+use stormath::spatial_vector::SpatialVector;
+use stormath::spatial_vector::transformations::RotationType;
+use stormath::type_aliases::Float;
+
+/// Rotation matrix, given as rows, for a rotation around the z-axis
+fn rotation_matrix_z(angle: Float) -> [[Float; 3]; 3] {
+    [
+        [angle.cos(), -angle.sin(), 0.0],
+        [angle.sin(),  angle.cos(), 0.0],
+        [0.0,          0.0,         1.0],
+    ]
+}
+
+#[test]
+/// Checks that the rotation vector from a rotation matrix gives the same rotation as the matrix
+fn rotation_from_matrix_matches_matrix() {
+    let rotation = SpatialVector::from([0.3, -0.2, 1.1]);
+
+    let axes = [SpatialVector::unit_x(), SpatialVector::unit_y(), SpatialVector::unit_z()]
+        .map(|axis| axis.rotate(rotation, RotationType::XYZ));
+
+    let mut matrix = [[0.0; 3]; 3];
+
+    for i in 0..3 {
+        for j in 0..3 {
+            matrix[i][j] = axes[j][i];
+        }
+    }
+
+    let computed_rotation = rotation_from_matrix(&matrix);
+
+    for i in 0..3 {
+        assert!((computed_rotation[i] - rotation[i]).abs() < 1e-6);
+    }
+}
+
+#[test]
+/// Checks that the control points follow the body frame motion, relative to the position of the
+/// model when the reference was set, and that the motion velocity is computed from the change in
+/// position.
+fn model_follows_body_frame_motion() {
+    let mut builder = ActuatorLineBuilder::new(get_wing_model_builder());
+    builder.line_force_model.translation = SpatialVector::from([1.0, 0.0, 0.0]);
+
+    let mut actuator_line = builder.build();
+
+    actuator_line.set_body_frame_reference();
+
+    let reference_points = actuator_line.line_force_model.ctrl_points_global.clone();
+
+    let angle: Float = 0.1;
+    let translation = SpatialVector::from([0.5, 0.2, 0.0]);
+    let time_step: Float = 0.1;
+
+    let matrix = rotation_matrix_z(angle);
+
+    actuator_line.move_with_body_frame(matrix, translation, time_step);
+
+    for (point, reference_point) in actuator_line.line_force_model.ctrl_points_global.iter()
+        .zip(reference_points.iter())
+    {
+        let expected_point = SpatialVector::from([
+            matrix[0][0] * reference_point[0] + matrix[0][1] * reference_point[1],
+            matrix[1][0] * reference_point[0] + matrix[1][1] * reference_point[1],
+            reference_point[2],
+        ]) + translation;
+
+        assert!(point.distance(expected_point) < 1e-6);
+    }
+
+    let motion = &actuator_line.line_force_model.rigid_body_motion;
+
+    assert!((motion.velocity_angular[2] - angle / time_step).abs() < 1e-6);
+
+    // Moving with the same transformation again leaves the model in the same place
+    actuator_line.move_with_body_frame(matrix, translation, time_step);
+
+    let motion = &actuator_line.line_force_model.rigid_body_motion;
+
+    assert!(motion.velocity_linear.length() < 1e-6);
+    assert!(motion.velocity_angular.length() < 1e-6);
+}
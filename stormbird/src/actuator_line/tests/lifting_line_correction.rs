@@ -0,0 +1,88 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+use crate::actuator_line::corrections::lifting_line::LiftingLineCorrectionBuilder;
+
+use super::get_wing_model;
+
+use stormath::spatial_vector::SpatialVector;
+use stormath::type_aliases::Float;
+
+fn velocity_in_direction(angle: Float, nr_span_lines: usize) -> Vec<SpatialVector> {
+    vec![SpatialVector::from([angle.cos(), angle.sin(), 0.0]); nr_span_lines]
+}
+
+fn assert_equal_corrections(first: &[SpatialVector], second: &[SpatialVector]) {
+    for (u_first, u_second) in first.iter().zip(second.iter()) {
+        assert!((*u_first - *u_second).length() < 1e-6, "{} != {}", u_first, u_second);
+    }
+}
+
+#[test]
+/// Checks that the stored induced velocity factors give the same correction as newly computed 
+/// factors, when the circulation strength changes between the calls.
+fn stored_correction_matches_new_correction() {
+    let line_force_model = get_wing_model();
+    let nr_span_lines = line_force_model.nr_span_lines();
+
+    let builder = LiftingLineCorrectionBuilder::default();
+
+    let mut correction = builder.build(1.0, &line_force_model);
+
+    let velocity = velocity_in_direction(0.1, nr_span_lines);
+
+    let first_circulation: Vec<Float> = (0..nr_span_lines).map(|i| 1.0 + i as Float).collect();
+    let second_circulation: Vec<Float> = (0..nr_span_lines).map(|i| 2.0 - 0.1 * i as Float).collect();
+
+    correction.velocity_correction(&line_force_model, &velocity, &first_circulation, 1.0);
+
+    let stored_result = correction.velocity_correction(
+        &line_force_model, &velocity, &second_circulation, 1.0
+    );
+
+    let new_result = builder.build(1.0, &line_force_model).velocity_correction(
+        &line_force_model, &velocity, &second_circulation, 1.0
+    );
+
+    assert_equal_corrections(&stored_result, &new_result);
+}
+
+#[test]
+/// Checks that the factors are only recomputed when the wake direction changes by more than the
+/// tolerance.
+fn correction_is_updated_outside_direction_tolerance() {
+    let line_force_model = get_wing_model();
+    let nr_span_lines = line_force_model.nr_span_lines();
+
+    let builder = LiftingLineCorrectionBuilder {
+        wake_direction_tolerance: 0.05,
+        ..Default::default()
+    };
+
+    let circulation = vec![1.0; nr_span_lines];
+
+    let correction_in_direction = |angle: Float| {
+        builder.build(1.0, &line_force_model).velocity_correction(
+            &line_force_model, &velocity_in_direction(angle, nr_span_lines), &circulation, 1.0
+        )
+    };
+
+    let mut correction = builder.build(1.0, &line_force_model);
+
+    correction.velocity_correction(
+        &line_force_model, &velocity_in_direction(0.0, nr_span_lines), &circulation, 1.0
+    );
+
+    let result_inside_tolerance = correction.velocity_correction(
+        &line_force_model, &velocity_in_direction(0.02, nr_span_lines), &circulation, 1.0
+    );
+
+    assert_equal_corrections(&result_inside_tolerance, &correction_in_direction(0.0));
+
+    let result_outside_tolerance = correction.velocity_correction(
+        &line_force_model, &velocity_in_direction(0.5, nr_span_lines), &circulation, 1.0
+    );
+
+    assert_equal_corrections(&result_outside_tolerance, &correction_in_direction(0.5));
+}
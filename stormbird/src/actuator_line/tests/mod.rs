@@ -0,0 +1,86 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+//! Tests for the actuator line functionality.
+
+use crate::line_force_model::builder::single_wing::WingBuilder;
+use crate::line_force_model::builder::LineForceModelBuilder;
+use crate::line_force_model::LineForceModel;
+use crate::line_force_model::input_power::InputPowerModel;
+
+use crate::actuator_line::ActuatorLine;
+use crate::actuator_line::builder::ActuatorLineBuilder;
+
+use crate::section_models::SectionModel;
+use crate::section_models::foil::Foil;
+
+use stormath::spatial_vector::SpatialVector;
+
+#[cfg(test)]
+mod projection;
+
+#[cfg(test)]
+mod lifting_line_correction;
+
+#[cfg(test)]
+mod sub_stepping;
+
+#[cfg(test)]
+mod batch_projection;
+
+#[cfg(test)]
+mod restart;
+
+#[cfg(test)]
+mod result_stream;
+
+#[cfg(test)]
+mod workspace;
+
+#[cfg(test)]
+mod body_frame;
+
+/// A single rectangular wing, oriented along the z-axis.
+pub fn get_wing_model() -> LineForceModel {
+    get_wing_model_builder().build()
+}
+
+/// Builder for the model returned by [get_wing_model]
+pub fn get_wing_model_builder() -> LineForceModelBuilder {
+    let mut builder = LineForceModelBuilder::new(10);
+
+    let wing = WingBuilder{
+        section_points: vec![
+            SpatialVector::from([0.0, 0.0, 0.0]),
+            SpatialVector::from([0.0, 0.0, 4.0]),
+        ],
+        chord_vectors: vec![
+            SpatialVector::from([1.0, 0.0, 0.0]),
+            SpatialVector::from([1.0, 0.0, 0.0]),
+        ],
+        line_segment_is_virtual: None,
+        section_model: SectionModel::Foil(Foil::default()),
+        non_zero_circulation_at_ends: [false, false],
+        nr_sections: None,
+        input_power_model: InputPowerModel::NoPower,
+    };
+
+    builder.add_wing(wing);
+
+    builder
+}
+
+/// Builds the actuator line model from the input builder, with the same free stream velocity at 
+/// all control points
+pub fn get_actuator_line(builder: ActuatorLineBuilder) -> ActuatorLine {
+    let mut actuator_line = builder.build();
+
+    let velocity = SpatialVector::from([5.0, 0.5, 0.0]);
+
+    for line_velocity in actuator_line.ctrl_points_velocity.iter_mut() {
+        *line_velocity = velocity;
+    }
+
+    actuator_line
+}
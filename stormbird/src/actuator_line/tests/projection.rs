@@ -0,0 +1,112 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+use crate::actuator_line::projection::gaussian::Gaussian;
+use crate::line_force_model::span_line::SpanLine;
+
+use stormath::spatial_vector::SpatialVector;
+use stormath::type_aliases::Float;
+
+#[test]
+/// Checks that the projection value is below the weight limit everywhere outside the bounding box,
+/// also for a chord vector that is not normal to the span line.
+fn bounding_box_is_conservative() {
+    let gaussian = Gaussian::default();
+
+    let span_line = SpanLine {
+        start_point: SpatialVector::new(0.0, 0.0, 0.0),
+        end_point: SpatialVector::new(0.1, 0.05, 0.5),
+    };
+
+    let chord_vector = SpatialVector::new(1.0, 0.2, 0.1);
+
+    let weight_limit = 0.001;
+
+    let [min_point, max_point] = gaussian.bounding_box(
+        chord_vector, &span_line, weight_limit
+    ).unwrap();
+
+    let nr_points = 41;
+    let sample_length: Float = 3.0;
+
+    let mut nr_points_inside = 0;
+
+    for i in 0..nr_points {
+        for j in 0..nr_points {
+            for k in 0..nr_points {
+                let relative_position = SpatialVector::new(
+                    i as Float / (nr_points - 1) as Float - 0.5,
+                    j as Float / (nr_points - 1) as Float - 0.5,
+                    k as Float / (nr_points - 1) as Float - 0.5,
+                ) * sample_length;
+
+                let point = span_line.ctrl_point() + relative_position;
+
+                let inside_box = (0..3).all(
+                    |d| point[d] >= min_point[d] && point[d] <= max_point[d]
+                );
+
+                let value = gaussian.projection_value_at_point(point, chord_vector, &span_line);
+
+                if inside_box {
+                    nr_points_inside += 1;
+                } else {
+                    assert!(value <= weight_limit, "Value {} outside box at {}", value, point);
+                }
+            }
+        }
+    }
+
+    assert!(nr_points_inside > 0);
+}
+
+#[test]
+fn no_bounding_box_above_peak_value() {
+    let gaussian = Gaussian::default();
+
+    let span_line = SpanLine {
+        start_point: SpatialVector::new(0.0, 0.0, 0.0),
+        end_point: SpatialVector::new(0.0, 0.0, 1.0),
+    };
+
+    let chord_vector = SpatialVector::new(1.0, 0.0, 0.0);
+
+    assert!(gaussian.bounding_box(chord_vector, &span_line, 1.0e6).is_none());
+}
+
+#[test]
+/// Checks that the bounding sphere contains the bounding box for several rotations of the chord
+/// vector around the span line, which is how local wing angles are applied.
+fn bounding_radius_is_independent_of_wing_angle() {
+    let gaussian = Gaussian::default();
+
+    let span_line = SpanLine {
+        start_point: SpatialVector::new(0.0, 0.0, 0.0),
+        end_point: SpatialVector::new(0.0, 0.0, 0.25),
+    };
+
+    let chord_vector = SpatialVector::new(1.0, 0.0, 0.0);
+    let weight_limit = 0.001;
+
+    let radius = gaussian.bounding_radius(chord_vector, &span_line, weight_limit).unwrap();
+
+    let center = span_line.ctrl_point();
+
+    for i in 0..12 {
+        let angle = i as Float * 0.5;
+
+        let rotated_chord_vector = chord_vector.rotate_around_axis(
+            angle, span_line.relative_vector()
+        );
+
+        let [min_point, max_point] = gaussian.bounding_box(
+            rotated_chord_vector, &span_line, weight_limit
+        ).unwrap();
+
+        for d in 0..3 {
+            assert!(center[d] - min_point[d] <= radius);
+            assert!(max_point[d] - center[d] <= radius);
+        }
+    }
+}
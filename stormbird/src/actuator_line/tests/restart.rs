@@ -0,0 +1,71 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+use crate::actuator_line::ActuatorLine;
+use crate::actuator_line::builder::ActuatorLineBuilder;
+
+use super::{get_actuator_line, get_wing_model_builder};
+
+use stormath::type_aliases::Float;
+
+fn get_default_actuator_line() -> ActuatorLine {
+    get_actuator_line(ActuatorLineBuilder::new(get_wing_model_builder()))
+}
+
+#[test]
+/// Checks that a restarted model continues with the same state as the original model
+fn restarted_model_matches_original() {
+    let time_step: Float = 0.1;
+
+    let mut original = get_default_actuator_line();
+
+    for step in 0..5 {
+        original.do_step(step as Float * time_step, time_step);
+    }
+
+    original.line_force_model.local_wing_angles[0] = 0.2;
+    original.line_force_model.update_global_data_representations();
+
+    let json_string = serde_json::to_string(&original.restart_state()).unwrap();
+
+    let mut restarted = get_default_actuator_line();
+
+    assert_ne!(restarted.geometry_hash(), original.geometry_hash());
+
+    restarted.apply_restart_state(serde_json::from_str(&json_string).unwrap()).unwrap();
+
+    assert_eq!(restarted.geometry_hash(), original.geometry_hash());
+    assert_eq!(restarted.current_iteration, original.current_iteration);
+
+    let original_circulation = &original.simulation_result.as_ref().unwrap()
+        .force_input.circulation_strength;
+    let restarted_circulation = &restarted.simulation_result.as_ref().unwrap()
+        .force_input.circulation_strength;
+
+    assert_eq!(original_circulation, restarted_circulation);
+
+    // The next step should give the same forces in both models
+    let time = 5.0 * time_step;
+
+    original.do_step(time, time_step);
+    restarted.do_step(time, time_step);
+
+    for i in 0..original.line_force_model.nr_span_lines() {
+        assert_eq!(
+            original.sectional_lift_forces_to_project[i], 
+            restarted.sectional_lift_forces_to_project[i]
+        );
+    }
+}
+
+#[test]
+fn restart_state_must_fit_the_model() {
+    let mut actuator_line = get_default_actuator_line();
+
+    let mut state = actuator_line.restart_state();
+
+    state.local_wing_angles.push(0.0);
+
+    assert!(actuator_line.apply_restart_state(state).is_err());
+}
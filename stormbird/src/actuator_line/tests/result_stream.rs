@@ -0,0 +1,119 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+use crate::actuator_line::ActuatorLine;
+use crate::actuator_line::builder::ActuatorLineBuilder;
+use crate::common_utils::results::result_stream::read_result_stream;
+
+use super::{get_actuator_line, get_wing_model_builder};
+
+use stormath::type_aliases::Float;
+
+#[test]
+/// Checks that the binary result stream contains one record per step, with the same values as the
+/// simulation results, also when the stream is opened again by another model.
+fn result_stream_matches_simulation_results() {
+    let folder_path = std::env::temp_dir().join(
+        format!("stormbird_result_stream_test_{}", std::process::id())
+    );
+
+    let _ = std::fs::remove_dir_all(&folder_path);
+
+    let mut builder = ActuatorLineBuilder::new(get_wing_model_builder());
+    builder.write_binary_results = true;
+
+    let mut actuator_line = get_actuator_line(builder);
+
+    let time_step: Float = 0.1;
+    let nr_steps = 3;
+
+    let mut time_history = Vec::new();
+    let mut circulation_history = Vec::new();
+
+    for step in 0..nr_steps {
+        actuator_line.do_step(step as Float * time_step, time_step);
+        actuator_line.write_results(folder_path.to_str().unwrap());
+
+        let simulation_result = actuator_line.simulation_result.as_ref().unwrap();
+
+        time_history.push(simulation_result.time);
+        circulation_history.push(simulation_result.force_input.circulation_strength.clone());
+    }
+
+    // A copy of the model opens the existing stream again, as after a restart, and appends to it
+    let mut restarted_actuator_line = actuator_line.clone();
+
+    restarted_actuator_line.write_results(folder_path.to_str().unwrap());
+
+    time_history.push(time_history[nr_steps - 1]);
+    circulation_history.push(circulation_history[nr_steps - 1].clone());
+
+    let (header, records) = read_result_stream(
+        folder_path.join(ActuatorLine::RESULT_STREAM_FILE_NAME)
+    ).unwrap();
+
+    assert_eq!(records.len(), nr_steps + 1);
+    assert_eq!(header.nr_span_lines, actuator_line.line_force_model.nr_span_lines());
+
+    let time_field = header.fields.iter().find(|field| field.name == "time").unwrap();
+    let circulation_field = header.fields.iter()
+        .find(|field| field.name == "force_input.circulation_strength")
+        .unwrap();
+
+    assert_eq!(circulation_field.shape, vec![header.nr_span_lines]);
+
+    for (step, record) in records.iter().enumerate() {
+        assert_eq!(record.len(), header.record_length);
+        assert_eq!(record[time_field.offset], time_history[step] as f64);
+
+        let circulation = &record[
+            circulation_field.offset..circulation_field.offset + circulation_field.size()
+        ];
+
+        for (stored, expected) in circulation.iter().zip(circulation_history[step].iter()) {
+            assert_eq!(*stored, *expected as f64);
+        }
+    }
+
+    let _ = std::fs::remove_dir_all(&folder_path);
+}
+
+#[test]
+/// A model with a different layout than an existing result stream should not write to it, and 
+/// should not stop the simulation.
+fn result_stream_with_different_layout_is_not_modified() {
+    let folder_path = std::env::temp_dir().join(
+        format!("stormbird_result_stream_layout_test_{}", std::process::id())
+    );
+
+    let _ = std::fs::remove_dir_all(&folder_path);
+
+    let mut builder = ActuatorLineBuilder::new(get_wing_model_builder());
+    builder.write_binary_results = true;
+
+    let mut other_line_force_model_builder = get_wing_model_builder();
+    other_line_force_model_builder.nr_sections *= 2;
+
+    let mut other_builder = ActuatorLineBuilder::new(other_line_force_model_builder);
+    other_builder.write_binary_results = true;
+
+    let time_step: Float = 0.1;
+
+    for (step, builder) in [builder, other_builder].into_iter().enumerate() {
+        let mut actuator_line = get_actuator_line(builder);
+
+        actuator_line.do_step(step as Float * time_step, time_step);
+        actuator_line.write_results(folder_path.to_str().unwrap());
+        actuator_line.write_results(folder_path.to_str().unwrap());
+    }
+
+    let (header, records) = read_result_stream(
+        folder_path.join(ActuatorLine::RESULT_STREAM_FILE_NAME)
+    ).unwrap();
+
+    assert_eq!(header.nr_span_lines, 10);
+    assert_eq!(records.len(), 2);
+
+    let _ = std::fs::remove_dir_all(&folder_path);
+}
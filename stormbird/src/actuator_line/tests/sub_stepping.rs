@@ -0,0 +1,109 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+use crate::actuator_line::ActuatorLine;
+use crate::actuator_line::builder::ActuatorLineBuilder;
+use crate::actuator_line::solver::{SolverSettings, ForceInterpolation};
+
+use super::{get_actuator_line, get_wing_model_builder};
+
+use stormath::type_aliases::Float;
+
+fn get_actuator_line_with_settings(solver_settings: SolverSettings) -> ActuatorLine {
+    let mut builder = ActuatorLineBuilder::new(get_wing_model_builder());
+
+    builder.solver_settings = solver_settings;
+
+    get_actuator_line(builder)
+}
+
+/// Runs the model for the input number of steps, and returns the steps where it was solved
+fn solve_steps(actuator_line: &mut ActuatorLine, nr_steps: usize, time_step: Float) -> Vec<usize> {
+    let mut solve_steps = Vec::new();
+
+    for step in 0..nr_steps {
+        let time = step as Float * time_step;
+
+        if actuator_line.is_solve_step(time, time_step) {
+            solve_steps.push(step);
+        }
+
+        actuator_line.do_step(time, time_step);
+
+        // Repeated calls for the same time step should not change the answer
+        assert_eq!(
+            actuator_line.is_solve_step(time, time_step), 
+            solve_steps.last() == Some(&step)
+        );
+    }
+
+    solve_steps
+}
+
+#[test]
+fn solve_at_fixed_nr_of_steps() {
+    let mut actuator_line = get_actuator_line_with_settings(
+        SolverSettings {
+            solve_interval: 3,
+            ..Default::default()
+        }
+    );
+
+    assert_eq!(solve_steps(&mut actuator_line, 8, 0.01), vec![0, 3, 6]);
+    assert_eq!(actuator_line.current_iteration, 8);
+}
+
+#[test]
+fn solve_at_fixed_time_interval() {
+    let mut actuator_line = get_actuator_line_with_settings(
+        SolverSettings {
+            solve_time_interval: Some(0.05),
+            ..Default::default()
+        }
+    );
+
+    assert_eq!(solve_steps(&mut actuator_line, 12, 0.01), vec![0, 5, 10]);
+}
+
+#[test]
+/// Checks that the held forces are constant between each solve, and that the linearly 
+/// interpolated forces end up at the forces from the last solve before the next solve.
+fn forces_between_solves() {
+    let time_step = 0.01;
+    let solve_interval = 4;
+
+    let mut held = get_actuator_line_with_settings(
+        SolverSettings {
+            solve_interval,
+            force_interpolation: ForceInterpolation::Hold,
+            ..Default::default()
+        }
+    );
+
+    let mut interpolated = get_actuator_line_with_settings(
+        SolverSettings {
+            solve_interval,
+            force_interpolation: ForceInterpolation::Linear,
+            ..Default::default()
+        }
+    );
+
+    for step in 0..2 * solve_interval {
+        let time = step as Float * time_step;
+
+        held.do_step(time, time_step);
+        interpolated.do_step(time, time_step);
+
+        let held_force = held.sectional_lift_forces_to_project[5];
+        let interpolated_force = interpolated.sectional_lift_forces_to_project[5];
+
+        let solved_force = held.sub_step_state.end_lift_forces[5];
+
+        assert_eq!(held_force, solved_force);
+
+        if step % solve_interval == solve_interval - 1 {
+            assert!((interpolated_force - solved_force).length() < 1e-9);
+        }
+    }
+}
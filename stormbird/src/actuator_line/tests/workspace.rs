@@ -0,0 +1,46 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+use crate::actuator_line::builder::ActuatorLineBuilder;
+use crate::actuator_line::corrections::lifting_line::LiftingLineCorrectionBuilder;
+
+use super::{get_actuator_line, get_wing_model_builder};
+
+use stormath::type_aliases::Float;
+
+#[test]
+/// Checks that the solver workspace reuses the same memory at every time step, and that the in 
+/// place solve gives the same result as the regular solve.
+fn workspace_is_reused_between_steps() {
+    let mut builder = ActuatorLineBuilder::new(get_wing_model_builder());
+    builder.lifting_line_correction = Some(LiftingLineCorrectionBuilder::default());
+
+    let mut actuator_line = get_actuator_line(builder);
+
+    let time_step: Float = 0.1;
+
+    actuator_line.do_step(0.0, time_step);
+
+    let workspace = &actuator_line.workspace;
+
+    let circulation_pointer = workspace.solver_result.circulation_strength.as_ptr();
+    let velocity_pointer = workspace.solver_result.output_ctrl_points_velocity.as_ptr();
+
+    for step in 1..5 {
+        actuator_line.do_step(step as Float * time_step, time_step);
+    }
+
+    let workspace = &actuator_line.workspace;
+
+    assert_eq!(workspace.solver_result.circulation_strength.as_ptr(), circulation_pointer);
+    assert_eq!(workspace.solver_result.output_ctrl_points_velocity.as_ptr(), velocity_pointer);
+
+    let mut copy = actuator_line.clone();
+
+    let solver_result = actuator_line.solve(0.5, time_step);
+
+    copy.solve_in_place(0.5);
+
+    assert_eq!(solver_result.circulation_strength, copy.workspace.solver_result.circulation_strength);
+}
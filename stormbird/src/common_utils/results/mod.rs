@@ -8,3 +8,4 @@
 pub mod solver;
 pub mod simulation;
 pub mod simplfied;
+pub mod result_stream;
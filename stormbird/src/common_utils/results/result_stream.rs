@@ -0,0 +1,399 @@
+// Copyright (C) 2024, NTNU
+// Author: Jarle Vinje Kramer <jarlekramer@gmail.com; jarle.a.kramer@ntnu.no>
+// License: GPL v3.0 (see separate file LICENSE or https://www.gnu.org/licenses/gpl-3.0.html)
+
+//! Compact binary format for storing the full [SimulationResult] at every time step in a single
+//! file, as an alternative to text files.
+//!
+//! The file starts with the magic bytes `SBRESULT`, followed by the length of the header as a
+//! little endian `u64`, and a JSON header that describes the layout of each record. The header is
+//! padded with spaces, so that the records start at a multiple of eight bytes. After the header,
+//! the file contains one record per time step. Each record has the same size, and consists of
+//! little endian `f64` values, where the fields are stored one after the other in the order given
+//! by the header. Multi-dimensional fields are stored in row-major order.
+//!
+//! The fixed record size means that the file can be memory mapped directly as an array of
+//! records, for instance with `numpy.memmap`, and that new records can simply be appended.
+
+use std::fs::{File, OpenOptions};
+use std::io::{BufWriter, Read, Write};
+use std::path::Path;
+
+use serde::{Serialize, Deserialize};
+
+use stormath::spatial_vector::SpatialVector;
+use stormath::type_aliases::Float;
+
+use crate::error::Error;
+use crate::common_utils::forces_and_moments::IntegratedValues;
+
+use super::simulation::SimulationResult;
+
+const MAGIC: &[u8; 8] = b"SBRESULT";
+const FORMAT_VERSION: usize = 1;
+
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+/// Description of a single field in a record
+pub struct ResultStreamField {
+    pub name: String,
+    pub shape: Vec<usize>,
+    /// The index of the first value of the field in a record
+    pub offset: usize,
+}
+
+impl ResultStreamField {
+    pub fn size(&self) -> usize {
+        self.shape.iter().product()
+    }
+}
+
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+/// The header of a result stream, which describes the layout of the records
+pub struct ResultStreamHeader {
+    pub version: usize,
+    pub nr_span_lines: usize,
+    pub wing_indices: Vec<[usize; 2]>,
+    /// The number of values in each record
+    pub record_length: usize,
+    pub fields: Vec<ResultStreamField>,
+}
+
+impl ResultStreamHeader {
+    pub fn from_result(result: &SimulationResult) -> Self {
+        let mut fields = Vec::new();
+        let mut offset = 0;
+
+        for (name, shape, _) in record_fields(result) {
+            let field = ResultStreamField {
+                name: name.to_string(),
+                shape,
+                offset,
+            };
+
+            offset += field.size();
+
+            fields.push(field);
+        }
+
+        Self {
+            version: FORMAT_VERSION,
+            nr_span_lines: result.ctrl_points.len(),
+            wing_indices: result.wing_indices.iter().map(|range| [range.start, range.end]).collect(),
+            record_length: offset,
+            fields,
+        }
+    }
+
+    /// The number of bytes in each record
+    pub fn record_size(&self) -> usize {
+        8 * self.record_length
+    }
+
+    /// Returns the header as bytes, including the magic bytes and the header length
+    fn to_bytes(&self) -> Result<Vec<u8>, Error> {
+        let mut header_string = serde_json::to_string(self)?;
+
+        let padded_length = header_string.len().div_ceil(8) * 8;
+
+        while header_string.len() < padded_length {
+            header_string.push(' ');
+        }
+
+        let mut bytes = Vec::with_capacity(16 + padded_length);
+
+        bytes.extend_from_slice(MAGIC);
+        bytes.extend_from_slice(&(padded_length as u64).to_le_bytes());
+        bytes.extend_from_slice(header_string.as_bytes());
+
+        Ok(bytes)
+    }
+
+    /// Reads the header from the start of a file. Returns the header and the size of it in bytes,
+    /// which is where the first record starts.
+    fn read_from(file: &mut File) -> Result<(Self, usize), Error> {
+        let mut start = [0u8; 16];
+
+        file.read_exact(&mut start)?;
+
+        if &start[0..8] != MAGIC {
+            return Err(Error::CustomStringError(
+                "The file is not a Stormbird result stream".to_string()
+            ));
+        }
+
+        let header_length = u64::from_le_bytes(start[8..16].try_into().unwrap()) as usize;
+
+        let mut header_bytes = vec![0u8; header_length];
+
+        file.read_exact(&mut header_bytes)?;
+
+        let header: Self = serde_json::from_slice(&header_bytes)?;
+
+        Ok((header, 16 + header_length))
+    }
+}
+
+#[derive(Debug)]
+/// Appends results to a result stream file. The file handle is kept open between each write.
+pub struct ResultStreamWriter {
+    file: BufWriter<File>,
+    header: ResultStreamHeader,
+    record_bytes: Vec<u8>,
+}
+
+impl ResultStreamWriter {
+    /// Opens a result stream for writing. A new file is created with a header based on the input
+    /// result if the file does not exist. Otherwise, the results are appended to the existing
+    /// file, which must have the same layout. An incomplete record at the end of an existing file,
+    /// for instance from a simulation that was stopped while writing, is removed.
+    pub fn open<P: AsRef<Path>>(file_path: P, result: &SimulationResult) -> Result<Self, Error> {
+        let file_path = file_path.as_ref();
+
+        let header = ResultStreamHeader::from_result(result);
+
+        let file_is_empty = match std::fs::metadata(file_path) {
+            Ok(metadata) => metadata.len() == 0,
+            Err(_) => true,
+        };
+
+        let file = if file_is_empty {
+            let mut file = File::create(file_path)?;
+
+            file.write_all(&header.to_bytes()?)?;
+
+            file
+        } else {
+            let mut file = OpenOptions::new().read(true).write(true).open(file_path)?;
+
+            let (existing_header, data_start) = ResultStreamHeader::read_from(&mut file)?;
+
+            if existing_header != header {
+                return Err(Error::CustomStringError(format!(
+                    "The result stream in {} has a different layout than the current results",
+                    file_path.display()
+                )));
+            }
+
+            let data_length = file.metadata()?.len() as usize - data_start;
+            let complete_length = data_length - data_length % header.record_size();
+
+            file.set_len((data_start + complete_length) as u64)?;
+
+            drop(file);
+
+            OpenOptions::new().append(true).open(file_path)?
+        };
+
+        Ok(Self {
+            file: BufWriter::new(file),
+            record_bytes: Vec::with_capacity(header.record_size()),
+            header,
+        })
+    }
+
+    pub fn header(&self) -> &ResultStreamHeader {
+        &self.header
+    }
+
+    /// Appends the input result as a new record. The result must have the same layout as the
+    /// header of the stream.
+    pub fn write(&mut self, result: &SimulationResult) -> Result<(), Error> {
+        self.record_bytes.clear();
+
+        for (_, _, values) in record_fields(result) {
+            for value in values {
+                self.record_bytes.extend_from_slice(&value.to_le_bytes());
+            }
+        }
+
+        if self.record_bytes.len() != self.header.record_size() {
+            return Err(Error::CustomStringError(
+                "The result does not have the same layout as the result stream".to_string()
+            ));
+        }
+
+        self.file.write_all(&self.record_bytes)?;
+
+        Ok(())
+    }
+
+    pub fn flush(&mut self) -> Result<(), Error> {
+        self.file.flush()?;
+
+        Ok(())
+    }
+}
+
+#[derive(Debug, Default)]
+/// A result stream that is opened at the first write, and kept open after that, for models that 
+/// write results at every time step. If the stream fails, for instance because an existing file 
+/// has a different layout after a restart with other wings, the error is reported once and no 
+/// more results are written to the stream, so that the simulation itself can continue. A clone
+/// is not opened, as only one writer should append to each file.
+pub struct LazyResultStream {
+    writer: Option<ResultStreamWriter>,
+    has_failed: bool,
+}
+
+impl Clone for LazyResultStream {
+    fn clone(&self) -> Self {
+        Self::default()
+    }
+}
+
+impl LazyResultStream {
+    /// Appends the input result to the stream in the input file. The file path is only used when
+    /// the stream is opened.
+    pub fn write<P: AsRef<Path>>(&mut self, file_path: P, result: &SimulationResult) {
+        let file_path = file_path.as_ref();
+
+        if self.has_failed {
+            return;
+        }
+
+        if self.writer.is_none() {
+            match ResultStreamWriter::open(file_path, result) {
+                Ok(writer) => self.writer = Some(writer),
+                Err(error) => {
+                    self.report_failure(file_path, error);
+
+                    return;
+                }
+            }
+        }
+
+        if let Err(error) = self.writer.as_mut().unwrap().write(result) {
+            self.report_failure(file_path, error);
+        }
+    }
+
+    /// Writes buffered records to the file
+    pub fn flush(&mut self) {
+        if let Some(writer) = self.writer.as_mut() {
+            if let Err(error) = writer.flush() {
+                eprintln!("Failed to flush the result stream: {}", error);
+            }
+        }
+    }
+
+    fn report_failure(&mut self, file_path: &Path, error: Error) {
+        eprintln!(
+            "Failed to write to the result stream {}: {}. No more results are written to it.",
+            file_path.display(),
+            error
+        );
+
+        self.writer = None;
+        self.has_failed = true;
+    }
+}
+
+/// Reads all records in a result stream. Each record is returned as a flat vector of values, with
+/// the layout given by the header. Mostly intended for testing, as readers in other languages can
+/// map the file directly.
+pub fn read_result_stream<P: AsRef<Path>>(
+    file_path: P
+) -> Result<(ResultStreamHeader, Vec<Vec<f64>>), Error> {
+    let mut file = File::open(file_path)?;
+
+    let (header, _) = ResultStreamHeader::read_from(&mut file)?;
+
+    let mut data = Vec::new();
+
+    file.read_to_end(&mut data)?;
+
+    let records = data.chunks_exact(header.record_size()).map(|record_bytes| {
+        record_bytes.chunks_exact(8).map(
+            |value_bytes| f64::from_le_bytes(value_bytes.try_into().unwrap())
+        ).collect()
+    }).collect();
+
+    Ok((header, records))
+}
+
+/// The fields that are stored in each record, given as the name, the shape and the values. This is
+/// used both to create the header and to write the records, so that the two always match.
+fn record_fields(result: &SimulationResult) -> Vec<(&'static str, Vec<usize>, Vec<f64>)> {
+    let nr_span_lines = result.ctrl_points.len();
+    let nr_wings = result.wing_indices.len();
+
+    let scalar = |value: Float| vec![value as f64];
+
+    let scalars = |values: &[Float]| -> Vec<f64> {
+        values.iter().map(|value| *value as f64).collect()
+    };
+
+    let vector = |value: SpatialVector| -> Vec<f64> {
+        (0..3).map(|i| value[i] as f64).collect()
+    };
+
+    let vectors = |values: &[SpatialVector]| -> Vec<f64> {
+        values.iter().flat_map(|value| vector(*value)).collect()
+    };
+
+    let integrated = |
+        values: &[IntegratedValues], component: fn(&IntegratedValues) -> SpatialVector
+    | -> Vec<f64> {
+        values.iter().flat_map(|value| vector(component(value))).collect()
+    };
+
+    let force_input = &result.force_input;
+    let sectional_forces = &result.sectional_forces;
+    let motion = &result.rigid_body_motion;
+
+    let line_scalar = vec![nr_span_lines];
+    let line_vector = vec![nr_span_lines, 3];
+    let wing_vector = vec![nr_wings, 3];
+
+    vec![
+        ("time", vec![], scalar(result.time)),
+        ("iterations", vec![], vec![result.iterations as f64]),
+        ("residual", vec![], scalar(result.residual)),
+        ("ctrl_points", line_vector.clone(), vectors(&result.ctrl_points)),
+        (
+            "solver_input_ctrl_points_velocity",
+            line_vector.clone(),
+            vectors(&result.solver_input_ctrl_points_velocity)
+        ),
+        (
+            "force_input.circulation_strength",
+            line_scalar.clone(),
+            scalars(&force_input.circulation_strength)
+        ),
+        ("force_input.velocity", line_vector.clone(), vectors(&force_input.velocity)),
+        (
+            "force_input.angles_of_attack",
+            line_scalar.clone(),
+            scalars(&force_input.angles_of_attack)
+        ),
+        ("force_input.acceleration", line_vector.clone(), vectors(&force_input.acceleration)),
+        ("force_input.rotation_velocity", vec![3], vector(force_input.rotation_velocity)),
+        ("sectional_forces.circulatory", line_vector.clone(), vectors(&sectional_forces.circulatory)),
+        ("sectional_forces.viscous_lift", line_vector.clone(), vectors(&sectional_forces.viscous_lift)),
+        (
+            "sectional_forces.sectional_drag",
+            line_vector.clone(),
+            vectors(&sectional_forces.sectional_drag)
+        ),
+        ("sectional_forces.added_mass", line_vector.clone(), vectors(&sectional_forces.added_mass)),
+        ("sectional_forces.gyroscopic", line_vector.clone(), vectors(&sectional_forces.gyroscopic)),
+        ("sectional_forces.total", line_vector.clone(), vectors(&sectional_forces.total)),
+        ("integrated_forces.circulatory", wing_vector.clone(), integrated(&result.integrated_forces, |v| v.circulatory)),
+        ("integrated_forces.viscous_lift", wing_vector.clone(), integrated(&result.integrated_forces, |v| v.viscous_lift)),
+        ("integrated_forces.sectional_drag", wing_vector.clone(), integrated(&result.integrated_forces, |v| v.sectional_drag)),
+        ("integrated_forces.added_mass", wing_vector.clone(), integrated(&result.integrated_forces, |v| v.added_mass)),
+        ("integrated_forces.gyroscopic", wing_vector.clone(), integrated(&result.integrated_forces, |v| v.gyroscopic)),
+        ("integrated_forces.total", wing_vector.clone(), integrated(&result.integrated_forces, |v| v.total)),
+        ("integrated_moments.circulatory", wing_vector.clone(), integrated(&result.integrated_moments, |v| v.circulatory)),
+        ("integrated_moments.viscous_lift", wing_vector.clone(), integrated(&result.integrated_moments, |v| v.viscous_lift)),
+        ("integrated_moments.sectional_drag", wing_vector.clone(), integrated(&result.integrated_moments, |v| v.sectional_drag)),
+        ("integrated_moments.added_mass", wing_vector.clone(), integrated(&result.integrated_moments, |v| v.added_mass)),
+        ("integrated_moments.gyroscopic", wing_vector.clone(), integrated(&result.integrated_moments, |v| v.gyroscopic)),
+        ("integrated_moments.total", wing_vector.clone(), integrated(&result.integrated_moments, |v| v.total)),
+        ("input_power", vec![nr_wings], scalars(&result.input_power)),
+        ("rigid_body_motion.translation", vec![3], vector(motion.translation)),
+        ("rigid_body_motion.rotation", vec![3], vector(motion.rotation)),
+        ("rigid_body_motion.velocity_linear", vec![3], vector(motion.velocity_linear)),
+        ("rigid_body_motion.velocity_angular", vec![3], vector(motion.velocity_angular)),
+    ]
+}
@@ -7,7 +7,7 @@ use stormath::{
     type_aliases::Float,
 };
 
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, Default)]
 /// Results from a lifting line solver, which will be further used to generate SimulationResults
 pub struct SolverResult {
     pub input_ctrl_points_velocity: Vec<SpatialVector>,
@@ -265,7 +265,7 @@ impl Simulation {
             let _need_update = actuator_line.model.update_controller(time, time_step);
         }
 
-        if let Some(actuator_line) = &self.actuator_line {
+        if let Some(actuator_line) = self.actuator_line.as_mut() {
             actuator_line.model.write_results("postProcessing");
         }
 